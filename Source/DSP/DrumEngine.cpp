@@ -1,39 +1,51 @@
 #include "DrumEngine.h"
+#include <map>
 
-void DrumEngine::prepare (double sampleRate, int maxBlockSize)
-{
-    for (auto& voice : voices)
-        voice.prepare (sampleRate, maxBlockSize);
-}
-
-void DrumEngine::initParameters (juce::AudioProcessorValueTreeState& apvts)
+namespace
 {
-    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+    // One part's parameter pointers, looked up by ID through resolve
+    template <typename Resolve>
+    DrumVoice::ParameterRefs makeParameterRefs (int i, Resolve&& resolve)
     {
         DrumVoice::ParameterRefs refs;
 
         auto get = [&](const juce::String& suffix) {
-            return apvts.getRawParameterValue (ParamIDs::partParam (i, suffix));
+            return resolve (ParamIDs::partParam (i, suffix));
         };
         auto getEnv = [&](int e, const juce::String& suffix) {
-            return apvts.getRawParameterValue (ParamIDs::envParam (i, e, suffix));
+            return resolve (ParamIDs::envParam (i, e, suffix));
         };
 
         refs.s1Level = get (ParamIDs::S1_LEVEL);
         refs.s1Tune  = get (ParamIDs::S1_TUNE);
         refs.s1Start = get (ParamIDs::S1_START);
+        refs.s1Trim  = get (ParamIDs::S1_TRIM);
+        refs.s1Trans = get (ParamIDs::S1_TRANS);
+        refs.s1Norm  = get (ParamIDs::S1_NORM);
         refs.s2Level = get (ParamIDs::S2_LEVEL);
         refs.s2Tune  = get (ParamIDs::S2_TUNE);
         refs.s2Start = get (ParamIDs::S2_START);
+        refs.s2Trim  = get (ParamIDs::S2_TRIM);
+        refs.s2Trans = get (ParamIDs::S2_TRANS);
+        refs.s2Norm  = get (ParamIDs::S2_NORM);
         refs.synWave  = get (ParamIDs::SYN_WAVE);
+        refs.synMode  = get (ParamIDs::SYN_MODE);
         refs.synLevel = get (ParamIDs::SYN_LEVEL);
         refs.synTune  = get (ParamIDs::SYN_TUNE);
         refs.synPW    = get (ParamIDs::SYN_PW);
         refs.synFreq  = get (ParamIDs::SYN_FREQ);
+        refs.synRatio = get (ParamIDs::SYN_RATIO);
+        refs.synIndex = get (ParamIDs::SYN_INDEX);
+        refs.synFmEnv = get (ParamIDs::SYN_FMENV);
         refs.nseType  = get (ParamIDs::NSE_TYPE);
         refs.nseLevel = get (ParamIDs::NSE_LEVEL);
         refs.nseFilt  = get (ParamIDs::NSE_FILT);
         refs.nseTone  = get (ParamIDs::NSE_TONE);
+        refs.nseSeed  = get (ParamIDs::NSE_SEED);
+        refs.nseFMode = get (ParamIDs::NSE_FMODE);
+        refs.nseRes   = get (ParamIDs::NSE_RES);
+        refs.nseFEnv  = get (ParamIDs::NSE_FENV);
+        refs.nseFAmt  = get (ParamIDs::NSE_FAMT);
         refs.atDamp   = get (ParamIDs::AT_DAMP);
         refs.atRetrig = get (ParamIDs::AT_RETRIG);
         refs.volume   = get (ParamIDs::VOL);
@@ -47,6 +59,9 @@ void DrumEngine::initParameters (juce::AudioProcessorValueTreeState& apvts)
             refs.envD[e] = getEnv (e, ParamIDs::ENV_D);
             refs.envS[e] = getEnv (e, ParamIDs::ENV_S);
             refs.envR[e] = getEnv (e, ParamIDs::ENV_R);
+            refs.envAC[e] = getEnv (e, ParamIDs::ENV_AC);
+            refs.envDC[e] = getEnv (e, ParamIDs::ENV_DC);
+            refs.envRC[e] = getEnv (e, ParamIDs::ENV_RC);
         }
 
         refs.eaS1  = get (ParamIDs::EA_S1);
@@ -54,14 +69,72 @@ void DrumEngine::initParameters (juce::AudioProcessorValueTreeState& apvts)
         refs.eaSyn = get (ParamIDs::EA_SYN);
         refs.eaNse = get (ParamIDs::EA_NSE);
 
-        voices[(size_t) i].setParameterRefs (refs);
+        return refs;
     }
 }
 
+void DrumEngine::prepare (double sampleRate, int maxBlockSize)
+{
+    for (auto& voice : voices)
+        voice.prepare (sampleRate, maxBlockSize);
+}
+
+void DrumEngine::initParameters (juce::AudioProcessorValueTreeState& apvts)
+{
+    // A kit being switched in is played from its own copy of the values, in
+    // slot order, so the parameters themselves only change when the kit is
+    // handed over
+    auto slots = PluginState::getSlotParameters (apvts.processor);
+    std::map<juce::String, size_t> slotIndex;
+    for (size_t i = 0; i < slots.size(); ++i)
+        slotIndex[slots[i]->getParameterID()] = i;
+
+    kitValues.reset (new std::atomic<float>[slots.size()]());
+    numKitValues = slots.size();
+
+    auto fromHost = [&] (const juce::String& id) { return apvts.getRawParameterValue (id); };
+    auto fromKit = [&] (const juce::String& id) { return &kitValues[slotIndex.at (id)]; };
+
+    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+        voices[(size_t) i].setParameterRefs (makeParameterRefs (i, fromHost), makeParameterRefs (i, fromKit));
+
+    interpolationParam = apvts.getRawParameterValue (ParamIDs::INTERP);
+}
+
 void DrumEngine::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
 {
     int numSamples = buffer.getNumSamples();
 
+    // A newly published kit's values are copied before anything reads
+    // them, so the whole kit changes on this block
+    const auto* kit = kitHandle.beginRead();
+    auto kitGeneration = kit != nullptr ? kit->generation : 0u;
+    auto kitSwitched = false;
+
+    if (kitGeneration != appliedKitGeneration.load())
+    {
+        if (kit != nullptr)
+        {
+            kitSwitched = true;
+
+            auto num = juce::jmin (numKitValues, kit->parameterValues.size());
+            for (size_t i = 0; i < num; ++i)
+                kitValues[i].store (kit->parameterValues[i], std::memory_order_relaxed);
+        }
+
+        appliedKitGeneration.store (kitGeneration);
+    }
+
+    auto interpolation = SamplePlayer::Interpolation::Sinc;
+    if (! renderingOffline && interpolationParam != nullptr)
+        interpolation = static_cast<SamplePlayer::Interpolation> ((int) interpolationParam->load());
+
+    for (size_t i = 0; i < voices.size(); ++i)
+    {
+        voices[i].setInterpolation (interpolation);
+        voices[i].beginBlock (kit != nullptr ? &kit->parts[i] : nullptr, kitSwitched);
+    }
+
     // Process GUI triggers
     int numGuiTriggers = guiTriggerCount.exchange (0);
     for (int i = 0; i < numGuiTriggers; ++i)
@@ -71,13 +144,34 @@ void DrumEngine::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffe
             voices[(size_t) t.partIndex].trigger (t.velocity);
     }
 
-    // Process MIDI
+    // Render up to each MIDI event before handling it, so notes and
+    // pressure changes land on their own sample
+    int position = 0;
+
     for (const auto metadata : midi)
     {
-        auto msg = metadata.getMessage();
-        handleMidiEvent (msg);
+        auto eventPosition = juce::jlimit (0, numSamples, metadata.samplePosition);
+
+        if (eventPosition > position)
+        {
+            renderVoices (buffer, position, eventPosition - position);
+            position = eventPosition;
+        }
+
+        handleMidiEvent (metadata.getMessage());
     }
 
+    if (position < numSamples)
+        renderVoices (buffer, position, numSamples - position);
+
+    for (auto& voice : voices)
+        voice.endBlock();
+
+    kitHandle.endRead();
+}
+
+void DrumEngine::renderVoices (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
     // Determine solo state
     bool anySolo = false;
     for (auto& voice : voices)
@@ -94,7 +188,7 @@ void DrumEngine::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffe
         if (anySolo && ! voice.isSoloed())
             continue;
 
-        voice.processBlock (buffer, numSamples);
+        voice.processBlock (buffer, startSample, numSamples);
     }
 }
 
@@ -166,3 +260,20 @@ void DrumEngine::triggerVoiceFromGUI (int partIndex, float velocity)
         guiTriggerCount.store (idx + 1);
     }
 }
+
+SamplePlayer::MemoryUsage DrumEngine::getSampleMemoryUsage()
+{
+    SamplePlayer::MemoryUsage total;
+
+    for (auto& voice : voices)
+    {
+        for (auto* player : { &voice.getSample1(), &voice.getSample2() })
+        {
+            auto usage = player->getMemoryUsage();
+            total.heapBytes += usage.heapBytes;
+            total.mappedBytes += usage.mappedBytes;
+        }
+    }
+
+    return total;
+}
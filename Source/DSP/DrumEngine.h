@@ -1,6 +1,7 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
 #include "DrumVoice.h"
+#include "../Utility/PluginState.h"
 #include "../Utility/Constants.h"
 
 class DrumEngine
@@ -13,15 +14,42 @@ public:
 
     DrumVoice& getVoice (int index) { return voices[(size_t) index]; }
 
+    // Summed over every loaded sample slot (message thread)
+    SamplePlayer::MemoryUsage getSampleMemoryUsage();
+
     // For GUI trigger pads — injects a note into the next process block
     void triggerVoiceFromGUI (int partIndex, float velocity);
 
+    // Offline renders always use the best sample interpolation
+    void setNonRealtime (bool isNonRealtime) { renderingOffline = isNonRealtime; }
+
+    // Switches every part to kit at the start of the next block. The parts
+    // play the kit's own copy of the parameter values, samples and tables
+    // until nullptr is published again, which is when the kit has been
+    // handed over to the parameters and slots themselves (message thread)
+    void publishKit (std::shared_ptr<const Kit> kit) { kitHandle.publish (std::move (kit)); }
+
+    // The generation of the kit the audio thread last switched to, or 0
+    // after a block with none published
+    juce::uint32 getAppliedKitGeneration() const { return appliedKitGeneration.load(); }
+
 private:
     void handleMidiEvent (const juce::MidiMessage& msg);
+    void renderVoices (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
     int noteToPartIndex (int note) const;
 
     std::array<DrumVoice, Constants::NUM_PARTS> voices;
 
+    std::atomic<float>* interpolationParam = nullptr;
+
+    // The applied kit's parameter values, in slot order (see PluginState);
+    // written and read on the audio thread only
+    std::unique_ptr<std::atomic<float>[]> kitValues;
+    size_t numKitValues = 0;
+    RcuHandle<Kit> kitHandle;
+    std::atomic<juce::uint32> appliedKitGeneration { 0 };
+    bool renderingOffline = false;
+
     // GUI trigger FIFO
     struct GUITrigger { int partIndex; float velocity; };
     std::array<GUITrigger, 16> guiTriggerBuffer;
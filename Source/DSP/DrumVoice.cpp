@@ -7,17 +7,51 @@ void DrumVoice::prepare (double sampleRate, int maxBlockSize)
     synth.prepare (sampleRate);
     noise.prepare (sampleRate);
     envelopes.prepare (sampleRate, maxBlockSize);
+    dampen.reset (sampleRate, 0.01);
+    dampen.setCurrentAndTargetValue (1.0f);
 
     tempS1.resize ((size_t) maxBlockSize, 0.0f);
     tempS2.resize ((size_t) maxBlockSize, 0.0f);
     tempSyn.resize ((size_t) maxBlockSize, 0.0f);
     tempNse.resize ((size_t) maxBlockSize, 0.0f);
+    tempS1R.resize ((size_t) maxBlockSize, 0.0f);
+    tempS2R.resize ((size_t) maxBlockSize, 0.0f);
+    tempDampen.resize ((size_t) maxBlockSize, 0.0f);
     tempMix.resize ((size_t) maxBlockSize, 0.0f);
+    tempStereoL.resize ((size_t) maxBlockSize, 0.0f);
+    tempStereoR.resize ((size_t) maxBlockSize, 0.0f);
 }
 
-void DrumVoice::setParameterRefs (ParameterRefs refs)
+void DrumVoice::beginBlock (const Kit::Part* kitPart, bool kitSwitched) noexcept
 {
-    params = refs;
+    sample1.beginBlock();
+    sample2.beginBlock();
+    synth.beginBlock();
+
+    params = kitPart != nullptr ? kitParams : hostParams;
+
+    if (kitPart != nullptr)
+    {
+        if (kitSwitched)
+        {
+            sample1.switchBlockZones (kitPart->zones[0].get());
+            sample2.switchBlockZones (kitPart->zones[1].get());
+        }
+        else
+        {
+            sample1.overrideBlockZones (kitPart->zones[0].get());
+            sample2.overrideBlockZones (kitPart->zones[1].get());
+        }
+
+        synth.overrideBlockUserTable (kitPart->userTable.get());
+    }
+}
+
+void DrumVoice::setParameterRefs (ParameterRefs hostRefs, ParameterRefs kitRefs)
+{
+    hostParams = hostRefs;
+    kitParams = kitRefs;
+    params = hostParams;
 }
 
 void DrumVoice::readParameters()
@@ -28,20 +62,35 @@ void DrumVoice::readParameters()
     sample1.level = params.s1Level->load();
     sample1.tune = params.s1Tune->load();
     sample1.startPos = params.s1Start->load();
+    sample1.autoTrim = params.s1Trim->load() > 0.5f;
+    sample1.transient = (int) params.s1Trans->load();
+    sample1.autoGain = params.s1Norm->load() > 0.5f;
 
     sample2.level = params.s2Level->load();
     sample2.tune = params.s2Tune->load();
     sample2.startPos = params.s2Start->load();
+    sample2.autoTrim = params.s2Trim->load() > 0.5f;
+    sample2.transient = (int) params.s2Trans->load();
+    sample2.autoGain = params.s2Norm->load() > 0.5f;
 
     synth.waveform = static_cast<SynthOscillator::Waveform> ((int) params.synWave->load());
+    synth.mode = static_cast<SynthOscillator::Mode> ((int) params.synMode->load());
     synth.level = params.synLevel->load();
     synth.tune = params.synTune->load();
     synth.pulseWidth = params.synPW->load();
+    synth.fmRatio = params.synRatio->load();
+    synth.fmIndex = params.synIndex->load();
+    fmEnvelope = (int) params.synFmEnv->load() - 1;
 
     noise.type = static_cast<NoiseGenerator::Type> ((int) params.nseType->load());
     noise.level = params.nseLevel->load();
     noise.filterCutoff = params.nseFilt->load();
     noise.tone = params.nseTone->load();
+    noise.seed = (int) params.nseSeed->load();
+    noise.filterMode = static_cast<NoiseGenerator::FilterMode> ((int) params.nseFMode->load());
+    noise.resonance = params.nseRes->load();
+    noise.envelopeOctaves = params.nseFAmt->load();
+    noiseFilterEnvelope = (int) params.nseFEnv->load() - 1;
 
     atProcessor.config.dampenSensitivity = params.atDamp->load();
     atProcessor.config.retriggerThreshold = params.atRetrig->load();
@@ -57,6 +106,9 @@ void DrumVoice::readParameters()
         env.params.decay = params.envD[e]->load();
         env.params.sustain = params.envS[e]->load();
         env.params.release = params.envR[e]->load();
+        env.params.attackCurve = params.envAC[e]->load();
+        env.params.decayCurve = params.envDC[e]->load();
+        env.params.releaseCurve = params.envRC[e]->load();
     }
 
     // Read envelope assignments
@@ -73,6 +125,7 @@ void DrumVoice::trigger (float velocity)
     sample1.trigger (velocity);
     sample2.trigger (velocity);
     synth.trigger (velocity, params.synFreq != nullptr ? params.synFreq->load() : 60.0f);
+    noise.trigger();
     envelopes.triggerAll();
 }
 
@@ -92,44 +145,120 @@ void DrumVoice::applyAftertouch (float pressure)
     }
 }
 
-void DrumVoice::processBlock (juce::AudioBuffer<float>& output, int numSamples)
+void DrumVoice::setInterpolation (SamplePlayer::Interpolation quality)
+{
+    sample1.interpolation = quality;
+    sample2.interpolation = quality;
+}
+
+void DrumVoice::processBlock (juce::AudioBuffer<float>& output, int startSample, int numSamples)
 {
     if (! envelopes.isAnyActive())
         return;
 
     readParameters();
 
-    // Process envelopes
-    envelopes.processBlock (numSamples);
+    // Only render the envelopes something reads this block; the rest just
+    // advance, so re-routing mid-note picks them up where they should be
+    auto fmEnv = synth.mode == SynthOscillator::Mode::FM ? fmEnvelope : -1;
+    auto filterEnv = noise.filterMode != NoiseGenerator::FilterMode::OnePole ? noiseFilterEnvelope : -1;
+    juce::uint32 routed = 0;
+
+    for (auto e : envAssign)
+        routed |= 1u << e;
+    if (fmEnv >= 0)
+        routed |= 1u << fmEnv;
+    if (filterEnv >= 0)
+        routed |= 1u << filterEnv;
+
+    envelopes.processBlock (numSamples, routed);
 
     // Process each source
-    sample1.processBlock (tempS1.data(), numSamples);
-    sample2.processBlock (tempS2.data(), numSamples);
-    synth.processBlock (tempSyn.data(), numSamples);
-    noise.processBlock (tempNse.data(), numSamples);
+    int s1Channels = sample1.processBlock (tempS1.data(), tempS1R.data(), numSamples);
+    int s2Channels = sample2.processBlock (tempS2.data(), tempS2R.data(), numSamples);
+    synth.processBlock (tempSyn.data(), numSamples,
+                        fmEnv >= 0 ? envelopes.getEnvelopeOutput (fmEnv) : nullptr);
+    noise.processBlock (tempNse.data(), numSamples,
+                        filterEnv >= 0 ? envelopes.getEnvelopeOutput (filterEnv) : nullptr);
+
+    // Aftertouch dampening glides to its new value over 10 ms. While it
+    // moves it's a per-sample gain; once settled it folds into the pan gains.
+    dampen.setTargetValue (atProcessor.getDampenMultiplier());
+    const float* dampenRamp = nullptr;
+    float dampenGain = dampen.getTargetValue();
+
+    if (dampen.isSmoothing())
+    {
+        for (int i = 0; i < numSamples; ++i)
+            tempDampen[(size_t) i] = dampen.getNextValue();
+
+        dampenRamp = tempDampen.data();
+        dampenGain = 1.0f;
+    }
 
     // Mix sources with envelope modulation
-    float dampen = atProcessor.getDampenMultiplier();
-    float leftGain = volume * dampen * std::sqrt (0.5f * (1.0f - pan));
-    float rightGain = volume * dampen * std::sqrt (0.5f * (1.0f + pan));
+    float leftGain = volume * dampenGain * std::sqrt (0.5f * (1.0f - pan));
+    float rightGain = volume * dampenGain * std::sqrt (0.5f * (1.0f + pan));
 
-    auto* outL = output.getWritePointer (0);
-    auto* outR = output.getNumChannels() > 1 ? output.getWritePointer (1) : nullptr;
+    auto* outL = output.getWritePointer (0, startSample);
+    auto* outR = output.getNumChannels() > 1 ? output.getWritePointer (1, startSample) : nullptr;
 
     const float* envOut0 = envelopes.getEnvelopeOutput (envAssign[0]);
     const float* envOut1 = envelopes.getEnvelopeOutput (envAssign[1]);
     const float* envOut2 = envelopes.getEnvelopeOutput (envAssign[2]);
     const float* envOut3 = envelopes.getEnvelopeOutput (envAssign[3]);
 
+    // Mono bus: synth, noise and any mono sample slots. Whether a slot is
+    // silent, mono or stereo is decided once per block, not per sample.
+    auto* mono = tempMix.data();
     for (int i = 0; i < numSamples; ++i)
+        mono[i] = tempSyn[(size_t) i] * envOut2[i] + tempNse[(size_t) i] * envOut3[i];
+
+    if (s1Channels == 1)
+        juce::FloatVectorOperations::addWithMultiply (mono, tempS1.data(), envOut0, numSamples);
+    if (s2Channels == 1)
+        juce::FloatVectorOperations::addWithMultiply (mono, tempS2.data(), envOut1, numSamples);
+    if (dampenRamp != nullptr)
+        juce::FloatVectorOperations::multiply (mono, dampenRamp, numSamples);
+
+    juce::FloatVectorOperations::addWithMultiply (outL, mono, leftGain, numSamples);
+    if (outR != nullptr)
+        juce::FloatVectorOperations::addWithMultiply (outR, mono, rightGain, numSamples);
+
+    // Stereo bus: pan acts as a balance control using the same gains, so a
+    // stereo file with identical channels sounds exactly like its mono twin
+    if (s1Channels == 2 || s2Channels == 2)
     {
-        float mono = tempS1[(size_t) i] * envOut0[i]
-                   + tempS2[(size_t) i] * envOut1[i]
-                   + tempSyn[(size_t) i] * envOut2[i]
-                   + tempNse[(size_t) i] * envOut3[i];
+        auto* stereoL = tempStereoL.data();
+        auto* stereoR = tempStereoR.data();
+        juce::FloatVectorOperations::clear (stereoL, numSamples);
+        juce::FloatVectorOperations::clear (stereoR, numSamples);
+
+        if (s1Channels == 2)
+        {
+            juce::FloatVectorOperations::addWithMultiply (stereoL, tempS1.data(), envOut0, numSamples);
+            juce::FloatVectorOperations::addWithMultiply (stereoR, tempS1R.data(), envOut0, numSamples);
+        }
+        if (s2Channels == 2)
+        {
+            juce::FloatVectorOperations::addWithMultiply (stereoL, tempS2.data(), envOut1, numSamples);
+            juce::FloatVectorOperations::addWithMultiply (stereoR, tempS2R.data(), envOut1, numSamples);
+        }
+        if (dampenRamp != nullptr)
+        {
+            juce::FloatVectorOperations::multiply (stereoL, dampenRamp, numSamples);
+            juce::FloatVectorOperations::multiply (stereoR, dampenRamp, numSamples);
+        }
 
-        outL[i] += mono * leftGain;
         if (outR != nullptr)
-            outR[i] += mono * rightGain;
+        {
+            juce::FloatVectorOperations::addWithMultiply (outL, stereoL, leftGain, numSamples);
+            juce::FloatVectorOperations::addWithMultiply (outR, stereoR, rightGain, numSamples);
+        }
+        else
+        {
+            juce::FloatVectorOperations::add (stereoL, stereoR, numSamples);
+            juce::FloatVectorOperations::addWithMultiply (outL, stereoL, 0.5f * leftGain, numSamples);
+        }
     }
 }
@@ -5,6 +5,7 @@
 #include "NoiseGenerator.h"
 #include "EnvelopeBank.h"
 #include "AftertouchProcessor.h"
+#include "Kit.h"
 #include "../Utility/Constants.h"
 #include "../Utility/Parameters.h"
 
@@ -16,18 +17,33 @@ public:
         std::atomic<float>* s1Level = nullptr;
         std::atomic<float>* s1Tune = nullptr;
         std::atomic<float>* s1Start = nullptr;
+        std::atomic<float>* s1Trim = nullptr;
+        std::atomic<float>* s1Trans = nullptr;
+        std::atomic<float>* s1Norm = nullptr;
         std::atomic<float>* s2Level = nullptr;
         std::atomic<float>* s2Tune = nullptr;
         std::atomic<float>* s2Start = nullptr;
+        std::atomic<float>* s2Trim = nullptr;
+        std::atomic<float>* s2Trans = nullptr;
+        std::atomic<float>* s2Norm = nullptr;
         std::atomic<float>* synWave = nullptr;
+        std::atomic<float>* synMode = nullptr;
         std::atomic<float>* synLevel = nullptr;
         std::atomic<float>* synTune = nullptr;
         std::atomic<float>* synPW = nullptr;
         std::atomic<float>* synFreq = nullptr;
+        std::atomic<float>* synRatio = nullptr;
+        std::atomic<float>* synIndex = nullptr;
+        std::atomic<float>* synFmEnv = nullptr;
         std::atomic<float>* nseType = nullptr;
         std::atomic<float>* nseLevel = nullptr;
         std::atomic<float>* nseFilt = nullptr;
         std::atomic<float>* nseTone = nullptr;
+        std::atomic<float>* nseSeed = nullptr;
+        std::atomic<float>* nseFMode = nullptr;
+        std::atomic<float>* nseRes = nullptr;
+        std::atomic<float>* nseFEnv = nullptr;
+        std::atomic<float>* nseFAmt = nullptr;
         std::atomic<float>* atDamp = nullptr;
         std::atomic<float>* atRetrig = nullptr;
         std::atomic<float>* volume = nullptr;
@@ -40,6 +56,9 @@ public:
         std::atomic<float>* envD[Constants::NUM_ENVELOPES_PER_PART] = {};
         std::atomic<float>* envS[Constants::NUM_ENVELOPES_PER_PART] = {};
         std::atomic<float>* envR[Constants::NUM_ENVELOPES_PER_PART] = {};
+        std::atomic<float>* envAC[Constants::NUM_ENVELOPES_PER_PART] = {};
+        std::atomic<float>* envDC[Constants::NUM_ENVELOPES_PER_PART] = {};
+        std::atomic<float>* envRC[Constants::NUM_ENVELOPES_PER_PART] = {};
 
         // Envelope assignments (choice params, stored as float 0-3)
         std::atomic<float>* eaS1 = nullptr;
@@ -49,14 +68,26 @@ public:
     };
 
     void prepare (double sampleRate, int maxBlockSize);
-    void setParameterRefs (ParameterRefs refs);
+    // hostRefs are the plugin's parameters; kitRefs the engine's copy of a
+    // kit's values, read instead while that kit is being switched in
+    void setParameterRefs (ParameterRefs hostRefs, ParameterRefs kitRefs);
     void trigger (float velocity);
     void release();
     void applyAftertouch (float pressure);
-    void processBlock (juce::AudioBuffer<float>& output, int numSamples);
+    void setInterpolation (SamplePlayer::Interpolation quality);
+
+    // Bracket each audio block (see SamplePlayer::beginBlock). While a kit
+    // is being switched in, its part stands in for the slots' own samples,
+    // the synth's user table and the parameters. kitSwitched marks the
+    // block the kit first plays in; sample notes it changes are stopped.
+    void beginBlock (const Kit::Part* kitPart = nullptr, bool kitSwitched = false) noexcept;
+    void endBlock() noexcept { sample1.endBlock(); sample2.endBlock(); synth.endBlock(); }
+    // Adds numSamples of the part into output from startSample on
+    void processBlock (juce::AudioBuffer<float>& output, int startSample, int numSamples);
 
     SamplePlayer& getSample1() { return sample1; }
     SamplePlayer& getSample2() { return sample2; }
+    SynthOscillator& getSynth() { return synth; }
 
     bool isMuted() const { return params.mute != nullptr && params.mute->load() > 0.5f; }
     bool isSoloed() const { return params.solo != nullptr && params.solo->load() > 0.5f; }
@@ -64,20 +95,31 @@ public:
 private:
     void readParameters();
 
-    ParameterRefs params;
+    ParameterRefs params;   // whichever of the two below this block reads
+    ParameterRefs hostParams, kitParams;
 
     SamplePlayer sample1, sample2;
     SynthOscillator synth;
     NoiseGenerator noise;
     EnvelopeBank envelopes;
     AftertouchProcessor atProcessor;
+    juce::SmoothedValue<float> dampen { 1.0f };   // aftertouch gain, ramped
 
     std::array<int, 4> envAssign = { 0, 0, 1, 2 };
+    int fmEnvelope = -1;   // envelope driving the FM index, or -1 for none
+    int noiseFilterEnvelope = -1;   // envelope sweeping the noise filter, or -1
 
     float volume = 1.0f;
     float pan = 0.0f;
 
-    // Temp buffers for per-source rendering
+    // Temp buffers for per-source rendering (the R buffers are only written
+    // by stereo samples)
     std::vector<float> tempS1, tempS2, tempSyn, tempNse;
+    std::vector<float> tempS1R, tempS2R;
+    std::vector<float> tempDampen;
+
+    // Mono sources are summed into tempMix and panned; stereo samples are
+    // summed into tempStereoL/R and balanced
     std::vector<float> tempMix;
+    std::vector<float> tempStereoL, tempStereoR;
 };
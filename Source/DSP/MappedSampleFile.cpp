@@ -0,0 +1,226 @@
+#include "MappedSampleFile.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    bool chunkIdIs (const juce::uint8* p, const char* id)
+    {
+        return std::memcmp (p, id, 4) == 0;
+    }
+}
+
+std::unique_ptr<MappedSampleFile> MappedSampleFile::open (const juce::File& file)
+{
+    std::unique_ptr<MappedSampleFile> result (new MappedSampleFile());
+    result->map = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+
+    if (result->map->getData() == nullptr)
+        return nullptr;
+
+    if (result->parseWav() || result->parseAiff())
+        return result;
+
+    return nullptr;
+}
+
+MappedSampleFile::~MappedSampleFile()
+{
+    if (locked)
+    {
+        auto range = getPageRange();
+       #if JUCE_WINDOWS
+        VirtualUnlock (range.first, range.second);
+       #else
+        munlock (range.first, range.second);
+       #endif
+    }
+}
+
+bool MappedSampleFile::parseWav()
+{
+    auto* base = static_cast<const juce::uint8*> (map->getData());
+    auto size = map->getSize();
+
+    if (size < 12 || ! chunkIdIs (base, "RIFF") || ! chunkIdIs (base + 8, "WAVE"))
+        return false;
+
+    int formatTag = 0, bitsPerSample = 0;
+    size_t dataOffset = 0, dataSize = 0;
+
+    for (size_t pos = 12; pos + 8 <= size;)
+    {
+        auto* chunk = base + pos;
+        auto chunkSize = (size_t) juce::ByteOrder::littleEndianInt (chunk + 4);
+        auto* body = chunk + 8;
+        auto available = size - (pos + 8);
+
+        if (chunkIdIs (chunk, "fmt ") && chunkSize >= 16 && available >= 16)
+        {
+            formatTag     = juce::ByteOrder::littleEndianShort (body);
+            numChannels   = juce::ByteOrder::littleEndianShort (body + 2);
+            bitsPerSample = juce::ByteOrder::littleEndianShort (body + 14);
+
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in its sub-format GUID
+            if (formatTag == 0xfffe && chunkSize >= 40 && available >= 40)
+                formatTag = juce::ByteOrder::littleEndianShort (body + 24);
+        }
+        else if (chunkIdIs (chunk, "data"))
+        {
+            dataOffset = pos + 8;
+            dataSize = juce::jmin (chunkSize, available);
+        }
+
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    if (dataOffset == 0 || numChannels <= 0 || (formatTag != 1 && formatTag != 3))
+        return false;
+
+    int frameBytes = numChannels * (bitsPerSample / 8);
+    if (frameBytes <= 0)
+        return false;
+
+    numFrames = (juce::int64) (dataSize / (size_t) frameBytes);
+    return setFrames (dataOffset, bitsPerSample, formatTag == 3, false);
+}
+
+bool MappedSampleFile::parseAiff()
+{
+    auto* base = static_cast<const juce::uint8*> (map->getData());
+    auto size = map->getSize();
+
+    if (size < 12 || ! chunkIdIs (base, "FORM"))
+        return false;
+
+    bool isAifc = chunkIdIs (base + 8, "AIFC");
+    if (! isAifc && ! chunkIdIs (base + 8, "AIFF"))
+        return false;
+
+    int bitsPerSample = 0;
+    bool isFloat = false, isBigEndian = true, haveComm = false;
+    size_t dataOffset = 0;
+
+    for (size_t pos = 12; pos + 8 <= size;)
+    {
+        auto* chunk = base + pos;
+        auto chunkSize = (size_t) juce::ByteOrder::bigEndianInt (chunk + 4);
+        auto* body = chunk + 8;
+        auto available = size - (pos + 8);
+
+        if (chunkIdIs (chunk, "COMM") && chunkSize >= 18 && available >= 18)
+        {
+            haveComm = true;
+            numChannels   = (juce::int16) juce::ByteOrder::bigEndianShort (body);
+            numFrames     = (juce::int64) juce::ByteOrder::bigEndianInt (body + 2);
+            bitsPerSample = (juce::int16) juce::ByteOrder::bigEndianShort (body + 6);
+
+            if (isAifc)
+            {
+                if (chunkSize < 22 || available < 22)
+                    return false;
+
+                auto* compression = body + 18;
+                if (chunkIdIs (compression, "sowt"))
+                    isBigEndian = false;
+                else if (chunkIdIs (compression, "fl32") || chunkIdIs (compression, "FL32"))
+                    isFloat = true;
+                else if (! chunkIdIs (compression, "NONE") && ! chunkIdIs (compression, "twos"))
+                    return false;
+            }
+        }
+        else if (chunkIdIs (chunk, "SSND") && available >= 8)
+        {
+            dataOffset = pos + 16 + (size_t) juce::ByteOrder::bigEndianInt (body);
+        }
+
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    if (! haveComm || dataOffset == 0 || numChannels <= 0)
+        return false;
+
+    return setFrames (dataOffset, bitsPerSample, isFloat, isBigEndian);
+}
+
+bool MappedSampleFile::setFrames (size_t dataOffset, int bitsPerSample, bool isFloat, bool isBigEndian)
+{
+    PcmView::Encoding encoding;
+
+    if (isFloat)
+    {
+        if (bitsPerSample != 32)
+            return false;
+        encoding = PcmView::Encoding::Float32;
+    }
+    else if (bitsPerSample == 16) encoding = PcmView::Encoding::Int16;
+    else if (bitsPerSample == 24) encoding = PcmView::Encoding::Int24;
+    else if (bitsPerSample == 32) encoding = PcmView::Encoding::Int32;
+    else return false;
+
+    int bytes = PcmView::bytesPerSample (encoding);
+    int frameStride = bytes * numChannels;
+
+    if (numFrames <= 0 || numFrames > std::numeric_limits<int>::max()
+        || dataOffset + (size_t) numFrames * (size_t) frameStride > map->getSize())
+        return false;
+
+    frames.data = static_cast<const juce::uint8*> (map->getData()) + dataOffset;
+    frames.encoding = encoding;
+    frames.bigEndian = isBigEndian;
+    frames.frameStride = frameStride;
+    frames.channelStride = bytes;
+    return true;
+}
+
+std::pair<void*, size_t> MappedSampleFile::getPageRange() const
+{
+   #if JUCE_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo (&info);
+    auto pageSize = (size_t) info.dwPageSize;
+   #else
+    auto pageSize = (size_t) sysconf (_SC_PAGESIZE);
+   #endif
+
+    auto start = (size_t) frames.data & ~(pageSize - 1);
+    auto end = (size_t) frames.data + (size_t) numFrames * (size_t) frames.frameStride;
+    return { (void*) start, end - start };
+}
+
+bool MappedSampleFile::lockPages()
+{
+    if (locked)
+        return true;
+
+    auto range = getPageRange();
+
+   #if JUCE_WINDOWS
+    locked = VirtualLock (range.first, range.second) != 0;
+   #else
+    locked = mlock (range.first, range.second) == 0;
+   #endif
+
+    return locked;
+}
+
+void MappedSampleFile::prefault() const
+{
+    constexpr size_t pageSize = 4096;
+    const volatile juce::uint8* p = frames.data;
+    auto numBytes = (size_t) numFrames * (size_t) frames.frameStride;
+
+    juce::uint8 sink = 0;
+    for (size_t i = 0; i < numBytes; i += pageSize)
+        sink ^= p[i];
+
+    juce::ignoreUnused (sink);
+}
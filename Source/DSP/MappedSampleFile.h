@@ -0,0 +1,48 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "PcmView.h"
+
+// Memory-maps an uncompressed WAV or AIFF file and locates its PCM frames so
+// SamplePlayer can play them straight from the mapped pages. The mapping is
+// read-only and shared, so the OS page cache backs every instance that loads
+// the same file.
+class MappedSampleFile
+{
+public:
+    // Returns nullptr for anything that can't be played in place: compressed
+    // or 8-bit data, RF64, unknown chunk layouts, or files that fail to map.
+    static std::unique_ptr<MappedSampleFile> open (const juce::File& file);
+
+    const PcmView& getFrames() const { return frames; }
+    int getNumChannels() const { return numChannels; }
+    juce::int64 getNumFrames() const { return numFrames; }
+    size_t getMappedSize() const { return map->getSize(); }
+
+    ~MappedSampleFile();
+
+    // Locks the sample data's pages in RAM (mlock / VirtualLock) so the
+    // audio thread never takes a page fault on them, faulting them in as it
+    // goes. Best-effort: returns false if the OS refuses, e.g. over the
+    // process's locked-memory limit. Call from the loading thread.
+    bool lockPages();
+
+    // Touches every page of the sample data once. Unlike lockPages this
+    // doesn't keep them resident: under memory pressure the OS can evict
+    // them again, and the next read faults on the audio thread.
+    void prefault() const;
+
+private:
+    MappedSampleFile() = default;
+
+    std::pair<void*, size_t> getPageRange() const;
+
+    bool parseWav();
+    bool parseAiff();
+    bool setFrames (size_t dataOffset, int bitsPerSample, bool isFloat, bool isBigEndian);
+
+    std::unique_ptr<juce::MemoryMappedFile> map;
+    PcmView frames;
+    int numChannels = 0;
+    juce::int64 numFrames = 0;
+    bool locked = false;
+};
@@ -0,0 +1,101 @@
+#include "MetallicBank.h"
+#include "FastSine.h"
+#include "PolyBlep.h"
+
+namespace
+{
+    // Oscillator frequencies of the 808's metal circuit, in Hz
+    constexpr std::array<double, 6> frequencies808 { 205.3, 304.4, 369.6, 522.7, 540.0, 800.0 };
+}
+
+void MetallicBank::Bandpass::setup (double sampleRate, double frequency, double q)
+{
+    // RBJ band-pass with 0 dB peak gain; b1 is 0 and b2 is -b0
+    auto w0 = juce::MathConstants<double>::twoPi * juce::jmin (frequency, 0.45 * sampleRate) / sampleRate;
+    auto alpha = std::sin (w0) / (2.0 * q);
+    auto a0 = 1.0 + alpha;
+
+    b0 = (float) (alpha / a0);
+    a1 = (float) (-2.0 * std::cos (w0) / a0);
+    a2 = (float) ((1.0 - alpha) / a0);
+}
+
+float MetallicBank::Bandpass::process (float x) noexcept
+{
+    // Transposed direct form II
+    auto y = b0 * x + s1;
+    s1 = -a1 * y + s2;
+    s2 = -b0 * x - a2 * y;
+    return y;
+}
+
+void MetallicBank::prepare (double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    lowBand.setup (sampleRate, 3440.0, 1.5);
+    highBand.setup (sampleRate, 7100.0, 1.5);
+    currentPitch = 0.0f;
+    reset();
+}
+
+void MetallicBank::reset()
+{
+    // Spread the starting phases, as free-running analogue oscillators would be
+    for (size_t l = 0; l < phases.size(); ++l)
+        phases[l] = (float) l / (float) lanes;
+
+    lowBand.s1 = lowBand.s2 = 0.0f;
+    highBand.s1 = highBand.s2 = 0.0f;
+}
+
+void MetallicBank::updateIncrements (float pitch)
+{
+    currentPitch = pitch;
+
+    for (size_t l = 0; l < (size_t) lanes; ++l)
+    {
+        // The spare lanes repeat real oscillators at zero gain, so every lane
+        // has a finite 1 / increment
+        auto frequency = frequencies808[l % frequencies808.size()] * (double) pitch;
+        auto increment = juce::jlimit (1.0e-6, 0.5, frequency / currentSampleRate);
+
+        increments[l] = (float) increment;
+        inverseIncrements[l] = (float) (1.0 / increment);
+        gains[l] = l < frequencies808.size() ? 1.0f / (float) frequencies808.size() : 0.0f;
+    }
+}
+
+void MetallicBank::render (float* output, int numSamples, float pitch)
+{
+    if (pitch != currentPitch)
+        updateIncrements (pitch);
+
+    // All lanes advance together; each is a 50% square, made as the
+    // difference of two saws half a cycle apart
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float sum = 0.0f;
+
+        for (size_t l = 0; l < (size_t) lanes; ++l)
+        {
+            auto t = FastSine::wrap (phases[l] + increments[l]);
+            phases[l] = t;
+
+            auto shifted = FastSine::wrap (t + 0.5f);
+            auto square = 2.0f * (shifted - t)
+                          + PolyBlep::residual (t, inverseIncrements[l])
+                          - PolyBlep::residual (shifted, inverseIncrements[l]);
+            sum += square * gains[l];
+        }
+
+        output[i] = sum;
+    }
+
+    // The two bands in parallel; the upper one carries the sizzle. The gains
+    // bring its level in line with the other noise modes.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto x = output[i];
+        output[i] = 1.5f * lowBand.process (x) + 3.0f * highBand.process (x);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// The TR-808 cymbal/hat source: six square oscillators at inharmonic
+// frequencies, summed and shaped by two band-pass filters. The squares are
+// band-limited (polyBLEP) and laid out as one 8-lane bank, so a sample is
+// a couple of vector operations rather than six serial oscillators.
+class MetallicBank
+{
+public:
+    void prepare (double sampleRate);
+
+    // Restarts the oscillators and clears the filters
+    void reset();
+
+    // pitch scales all six frequencies together
+    void render (float* output, int numSamples, float pitch);
+
+private:
+    static constexpr int lanes = 8;   // six oscillators, two silent to fill a vector
+
+    struct Bandpass
+    {
+        void setup (double sampleRate, double frequency, double q);
+        float process (float x) noexcept;
+
+        float b0 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        float s1 = 0.0f, s2 = 0.0f;
+    };
+
+    void updateIncrements (float pitch);
+
+    alignas (32) std::array<float, lanes> phases {};
+    alignas (32) std::array<float, lanes> increments {};
+    alignas (32) std::array<float, lanes> inverseIncrements {};
+    alignas (32) std::array<float, lanes> gains {};
+
+    Bandpass lowBand, highBand;
+    double currentSampleRate = 44100.0;
+    float currentPitch = 0.0f;
+};
@@ -7,72 +7,135 @@ void NoiseGenerator::prepare (double sampleRate)
     std::fill (std::begin (pinkState), std::end (pinkState), 0.0f);
     metalBuffer.fill (0.0f);
     metalWritePos = 0;
+    metalBank.prepare (sampleRate);
+    svf.prepare (sampleRate);
 }
 
-void NoiseGenerator::processBlock (float* output, int numSamples)
+void NoiseGenerator::trigger()
 {
+    // A seeded hit sounds the same every time, so renders are repeatable:
+    // every filter and delay starts from silence, not the last hit's tail
+    if (seed != 0)
+    {
+        whiteNoise.seed ((juce::uint32) seed);
+        filterState = 0.0f;
+        std::fill (std::begin (pinkState), std::end (pinkState), 0.0f);
+        metalBuffer.fill (0.0f);
+        metalWritePos = 0;
+        metalBank.reset();
+        svf.reset();
+    }
+}
+
+template <>
+void NoiseGenerator::shape<NoiseGenerator::Type::Pink> (float* samples, int numSamples)
+{
+    // Paul Kellet's filter, with its state kept in registers for the block
+    float b0 = pinkState[0], b1 = pinkState[1], b2 = pinkState[2], b3 = pinkState[3];
+    float b4 = pinkState[4], b5 = pinkState[5], b6 = pinkState[6];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float white = samples[i];
+        b0 = 0.99886f * b0 + white * 0.0555179f;
+        b1 = 0.99332f * b1 + white * 0.0750759f;
+        b2 = 0.96900f * b2 + white * 0.1538520f;
+        b3 = 0.86650f * b3 + white * 0.3104856f;
+        b4 = 0.55000f * b4 + white * 0.5329522f;
+        b5 = -0.7616f * b5 - white * 0.0168980f;
+        samples[i] = (b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f) * 0.11f;
+        b6 = white * 0.115926f;
+    }
+
+    pinkState[0] = b0; pinkState[1] = b1; pinkState[2] = b2; pinkState[3] = b3;
+    pinkState[4] = b4; pinkState[5] = b5; pinkState[6] = b6;
+}
+
+template <>
+void NoiseGenerator::shape<NoiseGenerator::Type::Metallic> (float* samples, int numSamples)
+{
+    // Karplus-Strong-esque short delay for inharmonic metallic tones
+    static_assert ((metalBufferSize & (metalBufferSize - 1)) == 0, "ring size must be a power of two");
+    constexpr int mask = metalBufferSize - 1;
+
+    int delayLen = std::max (4, (int) (tone * 250.0f + 6.0f));
+    int writePos = metalWritePos;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        int readPos = (writePos - delayLen) & mask;
+        float sample = samples[i] * 0.3f + metalBuffer[(size_t) readPos] * metalFeedback;
+
+        // Simple averaging filter for the feedback path
+        sample = (sample + metalBuffer[(size_t) ((readPos - 1) & mask)]) * 0.5f;
+
+        metalBuffer[(size_t) writePos] = sample;
+        samples[i] = sample;
+        writePos = (writePos + 1) & mask;
+    }
+
+    metalWritePos = writePos;
+}
+
+template <>
+void NoiseGenerator::shape<NoiseGenerator::Type::Metal808> (float* samples, int numSamples)
+{
+    metalBank.render (samples, numSamples, std::exp2 (2.0f * tone - 1.0f));
+}
+
+void NoiseGenerator::processBlock (float* output, int numSamples, const float* filterEnvelope)
+{
+    if (numSamples <= 0)
+        return;
+
     if (level <= 0.0001f)
     {
         juce::FloatVectorOperations::clear (output, numSamples);
         return;
     }
 
+    // White noise is generated straight into the output and shaped in place;
+    // the kernel is picked once per block
+    if (type != Type::Metal808)
+        whiteNoise.fill (output, numSamples);
+
+    switch (type)
+    {
+        case Type::White:    break;
+        case Type::Pink:     shape<Type::Pink> (output, numSamples); break;
+        case Type::Metallic: shape<Type::Metallic> (output, numSamples); break;
+        case Type::Metal808: shape<Type::Metal808> (output, numSamples); break;
+    }
+
+    if (filterMode != FilterMode::OnePole)
+    {
+        auto cutoffHz = 20.0f * std::exp2 (10.0f * std::clamp (filterCutoff, 0.0f, 1.0f));
+        auto mode = filterMode == FilterMode::Lowpass  ? StateVariableFilter::Mode::Lowpass
+                  : filterMode == FilterMode::Bandpass ? StateVariableFilter::Mode::Bandpass
+                                                       : StateVariableFilter::Mode::Highpass;
+
+        svf.process (output, numSamples, mode, cutoffHz, resonance, filterEnvelope, envelopeOctaves);
+        juce::FloatVectorOperations::multiply (output, level, numSamples);
+        return;
+    }
+
+    // One-pole lowpass. Map 0-1 to coefficient: 0 = very filtered, 1 = wide
+    // open (quadratic mapping for better feel).
+    float cutoff = std::clamp (filterCutoff, 0.0f, 1.0f);
+    float coeff = cutoff * cutoff;
+
+    if (coeff >= 1.0f)
+    {
+        filterState = output[numSamples - 1];
+        juce::FloatVectorOperations::multiply (output, level, numSamples);
+        return;
+    }
+
+    float state = filterState;
     for (int i = 0; i < numSamples; ++i)
     {
-        float white = random.nextFloat() * 2.0f - 1.0f;
-        float sample = 0.0f;
-
-        switch (type)
-        {
-            case Type::White:
-                sample = white;
-                break;
-
-            case Type::Pink:
-            {
-                pinkState[0] = 0.99886f * pinkState[0] + white * 0.0555179f;
-                pinkState[1] = 0.99332f * pinkState[1] + white * 0.0750759f;
-                pinkState[2] = 0.96900f * pinkState[2] + white * 0.1538520f;
-                pinkState[3] = 0.86650f * pinkState[3] + white * 0.3104856f;
-                pinkState[4] = 0.55000f * pinkState[4] + white * 0.5329522f;
-                pinkState[5] = -0.7616f * pinkState[5] - white * 0.0168980f;
-                sample = pinkState[0] + pinkState[1] + pinkState[2] + pinkState[3]
-                       + pinkState[4] + pinkState[5] + pinkState[6] + white * 0.5362f;
-                pinkState[6] = white * 0.115926f;
-                sample *= 0.11f;
-                break;
-            }
-
-            case Type::Metallic:
-            {
-                // Karplus-Strong-esque short delay for inharmonic metallic tones
-                int delayLen = std::max (4, (int) (tone * 250.0f + 6.0f));
-                int readPos = metalWritePos - delayLen;
-                if (readPos < 0)
-                    readPos += (int) metalBuffer.size();
-
-                float delayed = metalBuffer[(size_t) readPos];
-                sample = white * 0.3f + delayed * metalFeedback;
-
-                // Simple averaging filter for the feedback path
-                int readPos2 = readPos - 1;
-                if (readPos2 < 0)
-                    readPos2 += (int) metalBuffer.size();
-                sample = (sample + metalBuffer[(size_t) readPos2]) * 0.5f;
-
-                metalBuffer[(size_t) metalWritePos] = sample;
-                metalWritePos = (metalWritePos + 1) % (int) metalBuffer.size();
-                break;
-            }
-        }
-
-        // One-pole lowpass filter
-        float cutoff = std::clamp (filterCutoff, 0.0f, 1.0f);
-        // Map 0-1 to coefficient: 0 = very filtered, 1 = wide open
-        float coeff = cutoff * cutoff; // quadratic mapping for better feel
-        filterState = filterState + coeff * (sample - filterState);
-        sample = filterState;
-
-        output[i] = sample * level;
+        state += coeff * (output[i] - state);
+        output[i] = state * level;
     }
+    filterState = state;
 }
@@ -1,33 +1,57 @@
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_core/juce_core.h>
+#include "XorshiftNoise.h"
+#include "MetallicBank.h"
+#include "StateVariableFilter.h"
 
 class NoiseGenerator
 {
 public:
-    enum class Type { White, Pink, Metallic };
+    enum class Type { White, Pink, Metallic, Metal808 };
+
+    // OnePole is the original fixed lowpass; the others use a resonant SVF
+    // whose cutoff an envelope can sweep
+    enum class FilterMode { OnePole, Lowpass, Bandpass, Highpass };
 
     void prepare (double sampleRate);
-    void processBlock (float* output, int numSamples);
+    void trigger();
+
+    // filterEnvelope, if given, sweeps the SVF cutoff per sample
+    void processBlock (float* output, int numSamples, const float* filterEnvelope = nullptr);
 
     Type type = Type::White;
     float level = 1.0f;
-    float filterCutoff = 1.0f;
-    float tone = 0.5f;
+    float filterCutoff = 1.0f;   // 0-1; 20 Hz to 20 kHz in the SVF modes
+    FilterMode filterMode = FilterMode::OnePole;
+    float resonance = 0.0f;
+    float envelopeOctaves = 0.0f;   // sweep depth at full envelope
+    float tone = 0.5f;       // Metallic: delay length; Metal808: pitch, 0.5x to 2x
+    int seed = 0;   // non-zero: restart the noise from this seed on every trigger
 
 private:
-    juce::Random random;
+    // Per-type shaping of white noise, in place (Metal808 ignores its input)
+    template <Type noiseType>
+    void shape (float* samples, int numSamples);
+
+    XorshiftNoise whiteNoise;
 
     // Pink noise state (Paul Kellet's method)
     float pinkState[7] = {};
 
     // Metallic noise (short delay + feedback)
-    std::array<float, 256> metalBuffer = {};
+    static constexpr int metalBufferSize = 256;
+    std::array<float, metalBufferSize> metalBuffer = {};
     int metalWritePos = 0;
     float metalFeedback = 0.95f;
 
+    // 808-style six-square bank
+    MetallicBank metalBank;
+
     // One-pole filter
     float filterState = 0.0f;
 
+    StateVariableFilter svf;
+
     double currentSampleRate = 44100.0;
 };
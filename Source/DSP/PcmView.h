@@ -0,0 +1,29 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+// Describes packed PCM frames that SamplePlayer reads in place, converting a
+// block's worth to float as it plays rather than decoding up front.
+struct PcmView
+{
+    enum class Encoding { Int16, Int24, Int32, Float32 };
+
+    const juce::uint8* data = nullptr; // first sample of channel 0
+    Encoding encoding = Encoding::Int16;
+    bool bigEndian = false;
+    int frameStride = 0;   // bytes from one frame to the next
+    int channelStride = 0; // bytes from one channel to the next
+
+    bool isValid() const { return data != nullptr; }
+
+    static int bytesPerSample (Encoding e)
+    {
+        switch (e)
+        {
+            case Encoding::Int16:   return 2;
+            case Encoding::Int24:   return 3;
+            case Encoding::Int32:   return 4;
+            case Encoding::Float32: return 4;
+        }
+        return 0;
+    }
+};
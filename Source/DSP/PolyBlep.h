@@ -0,0 +1,18 @@
+#pragma once
+#include <cmath>
+
+namespace PolyBlep
+{
+    // polyBLEP residual for a phase t in [0, 1) advancing 1 / invDt per
+    // sample, written without compares so loops using it vectorise under
+    // default float semantics. The clamped ramps are zero outside the
+    // one-sample windows either side of the edge.
+    inline float residual (float t, float invDt) noexcept
+    {
+        auto x = t * invDt;
+        auto y = (t - 1.0f) * invDt;
+        auto a = 0.5f * (x - 1.0f - std::abs (x - 1.0f));   // min (x, 1) - 1
+        auto b = 0.5f * (y + 1.0f + std::abs (y + 1.0f));   // max (y, -1) + 1
+        return b * b - a * a;
+    }
+}
@@ -0,0 +1,270 @@
+#include "SampleAnalysis.h"
+#include "SampleAnalysisCache.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr int chunkSize = 4096;
+
+    // Calls fn (chunk, startFrame, numFrames) over the whole sample, converted
+    // to float a chunk at a time
+    template <typename Fn>
+    void forEachChunk (const SamplePlayer::SampleData& sample, Fn&& fn)
+    {
+        juce::AudioBuffer<float> chunk (sample.numChannels, chunkSize);
+
+        for (int start = 0; start < sample.numFrames; start += chunkSize)
+        {
+            int num = juce::jmin (chunkSize, sample.numFrames - start);
+            sample.readFrames (start, num, chunk.getArrayOfWritePointers());
+            fn (chunk, start, num);
+        }
+    }
+
+    // Largest absolute value across channels
+    float frameLevel (const juce::AudioBuffer<float>& chunk, int i)
+    {
+        float level = std::abs (chunk.getSample (0, i));
+        if (chunk.getNumChannels() > 1)
+            level = juce::jmax (level, std::abs (chunk.getSample (1, i)));
+        return level;
+    }
+
+    // BS.1770 K-weighting: a high shelf followed by a high-pass, with
+    // coefficients derived for any sample rate
+    struct KWeighting
+    {
+        struct Biquad
+        {
+            double b0, b1, b2, a1, a2;
+            double z1 = 0.0, z2 = 0.0;
+
+            double process (double x)
+            {
+                double y = b0 * x + z1;
+                z1 = b1 * x - a1 * y + z2;
+                z2 = b2 * x - a2 * y;
+                return y;
+            }
+        };
+
+        Biquad shelf, highPass;
+
+        explicit KWeighting (double sampleRate)
+        {
+            {
+                const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+                double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+                double vh = std::pow (10.0, gainDb / 20.0);
+                double vb = std::pow (vh, 0.4996667741545416);
+                double a0 = 1.0 + k / q + k * k;
+                shelf = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                          2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+            }
+            {
+                const double f0 = 38.13547087602444, q = 0.5003270373238773;
+                double k = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+                double a0 = 1.0 + k / q + k * k;
+                highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+            }
+        }
+
+        double process (double x) { return highPass.process (shelf.process (x)); }
+    };
+
+    double energyToLufs (double energy)
+    {
+        return -0.691 + 10.0 * std::log10 (juce::jmax (energy, 1.0e-20));
+    }
+
+    // Gated integrated loudness from mean-square energies of 100 ms steps,
+    // using 400 ms blocks with 75% overlap. Samples shorter than one block
+    // are measured as a single block.
+    float integratedLoudness (const std::vector<double>& stepEnergies, double wholeEnergy)
+    {
+        std::vector<double> blocks;
+        for (size_t i = 3; i < stepEnergies.size(); ++i)
+            blocks.push_back ((stepEnergies[i - 3] + stepEnergies[i - 2] + stepEnergies[i - 1] + stepEnergies[i]) * 0.25);
+
+        if (blocks.empty())
+            blocks.push_back (wholeEnergy);
+
+        auto gatedMean = [&blocks] (double gateLufs)
+        {
+            double sum = 0.0;
+            int count = 0;
+            for (auto e : blocks)
+            {
+                if (energyToLufs (e) > gateLufs)
+                {
+                    sum += e;
+                    ++count;
+                }
+            }
+            return count > 0 ? sum / count : 0.0;
+        };
+
+        double absoluteGated = gatedMean (-70.0);
+        if (absoluteGated <= 0.0)
+            return SampleAnalysis::silentLoudness;
+
+        return (float) energyToLufs (gatedMean (energyToLufs (absoluteGated) - 10.0));
+    }
+
+    struct Candidate
+    {
+        int frame;
+        float strength;
+    };
+}
+
+float SampleAnalysis::gainForLoudness (float lufs)
+{
+    if (lufs <= silentLoudness)
+        return 1.0f;
+    return juce::Decibels::decibelsToGain (juce::jlimit (-24.0f, 24.0f, targetLoudness - lufs));
+}
+
+std::unique_ptr<SampleAnalysis> SampleAnalysis::loadOrAnalyse (const SamplePlayer::SampleData& sample)
+{
+    auto key = SampleAnalysisCache::fingerprintFile (sample.file);
+
+    if (key != 0)
+        if (auto cached = SampleAnalysisCache::load (key))
+            return cached;
+
+    auto result = analyse (sample);
+
+    if (key != 0)
+        SampleAnalysisCache::store (key, *result);
+
+    return result;
+}
+
+std::unique_ptr<SampleAnalysis> SampleAnalysis::analyse (const SamplePlayer::SampleData& sample)
+{
+    auto result = std::make_unique<SampleAnalysis>();
+    auto sr = sample.sampleRate;
+
+    // Pass 1: peak, RMS and loudness
+    std::vector<KWeighting> kFilters ((size_t) sample.numChannels, KWeighting (sr));
+    const int stepLength = juce::jmax (1, juce::roundToInt (0.1 * sr));
+    std::vector<double> stepEnergies;
+    double stepSum = 0.0, kSum = 0.0, squareSum = 0.0;
+    int stepFill = 0;
+    float peak = 0.0f;
+
+    forEachChunk (sample, [&] (const juce::AudioBuffer<float>& chunk, int, int num)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            double weighted = 0.0;
+            for (int ch = 0; ch < sample.numChannels; ++ch)
+            {
+                float x = chunk.getSample (ch, i);
+                squareSum += (double) x * x;
+                double k = kFilters[(size_t) ch].process (x);
+                weighted += k * k;
+            }
+
+            peak = juce::jmax (peak, frameLevel (chunk, i));
+            stepSum += weighted;
+            kSum += weighted;
+
+            if (++stepFill == stepLength)
+            {
+                stepEnergies.push_back (stepSum / stepLength);
+                stepSum = 0.0;
+                stepFill = 0;
+            }
+        }
+    });
+
+    if (sample.numFrames > 0)
+    {
+        result->rms = (float) std::sqrt (squareSum / ((double) sample.numFrames * sample.numChannels));
+        result->loudness = integratedLoudness (stepEnergies, kSum / sample.numFrames);
+    }
+
+    result->peak = peak;
+    result->autoGain = gainForLoudness (result->loudness);
+
+    if (peak < 1.0e-5f)
+        return result;
+
+    // Pass 2: onsets, judged relative to the sample's own peak: -40 dB counts
+    // as sound, below -60 dB counts as silence
+    const float onsetThreshold = peak * 0.01f;
+    const float silenceThreshold = peak * 0.001f;
+    const int maxPreRoll = (int) (0.005 * sr);
+    const int refractory = (int) (0.05 * sr);
+
+    // Fast envelope: instant attack, 5 ms release. Slow envelope: 30 ms
+    // smoothing of the fast one. A transient is the fast envelope jumping
+    // 6 dB above the slow one.
+    const float fastRelease = (float) std::exp (-1.0 / (0.005 * sr));
+    const float slowCoeff = 1.0f - (float) std::exp (-1.0 / (0.03 * sr));
+
+    float fast = 0.0f, slow = 0.0f;
+    int firstAbove = -1, lastSilent = -1, lastOnset = -refractory;
+    float onsetFloor = 0.0f;
+    std::vector<Candidate> candidates;
+
+    forEachChunk (sample, [&] (const juce::AudioBuffer<float>& chunk, int start, int num)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            int frame = start + i;
+            float level = frameLevel (chunk, i);
+
+            if (firstAbove < 0)
+            {
+                if (level >= onsetThreshold)
+                    firstAbove = frame;
+                else if (level < silenceThreshold)
+                    lastSilent = frame;
+            }
+
+            fast = juce::jmax (level, fast * fastRelease);
+            slow += (fast - slow) * slowCoeff;
+
+            if (frame - lastOnset < refractory)
+            {
+                // Strength is how far the hit rises above what came before it
+                if (! candidates.empty())
+                    candidates.back().strength = juce::jmax (candidates.back().strength, fast / onsetFloor);
+            }
+            else if (fast >= onsetThreshold && fast > 2.0f * slow)
+            {
+                lastOnset = frame;
+                onsetFloor = slow + silenceThreshold;
+                candidates.push_back ({ frame, fast / onsetFloor });
+            }
+        }
+    });
+
+    if (firstAbove < 0)
+        return result;
+
+    result->firstOnset = juce::jmax (lastSilent + 1, firstAbove - maxPreRoll);
+
+    // Keep the strongest later transients, then put them back in time order
+    std::vector<Candidate> later;
+    for (auto& c : candidates)
+        if (c.frame >= firstAbove + refractory)
+            later.push_back (c);
+
+    std::stable_sort (later.begin(), later.end(),
+                      [] (const Candidate& a, const Candidate& b) { return a.strength > b.strength; });
+    if ((int) later.size() > maxTransients - 1)
+        later.resize ((size_t) maxTransients - 1);
+    std::sort (later.begin(), later.end(),
+               [] (const Candidate& a, const Candidate& b) { return a.frame < b.frame; });
+
+    result->transients[0] = result->firstOnset;
+    result->numTransients = 1;
+    for (auto& c : later)
+        result->transients[(size_t) result->numTransients++] = c.frame;
+
+    return result;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "SamplePlayer.h"
+
+// Load-time analysis of a sample, computed once on a background thread (or
+// read back from SampleAnalysisCache) and read by SamplePlayer::trigger()
+// without any searching.
+struct SampleAnalysis
+{
+    static constexpr int maxTransients = 8;
+    static constexpr float targetLoudness = -18.0f;  // LUFS, for auto-gain
+    static constexpr float silentLoudness = -70.0f;
+
+    float peak = 0.0f;                 // largest absolute sample value
+    float rms = 0.0f;                  // over all frames and channels
+    float loudness = silentLoudness;   // BS.1770 integrated loudness, LUFS
+    float autoGain = 1.0f;             // brings loudness to targetLoudness (±24 dB)
+
+    int firstOnset = 0;      // frame where the first hit starts (auto-trim point)
+
+    // Strongest transients in time order; transients[0] is always firstOnset
+    std::array<int, maxTransients> transients {};
+    int numTransients = 0;
+
+    // Frame of transient n (1-based), or of the last one found
+    int getTransient (int n) const
+    {
+        if (numTransients == 0)
+            return firstOnset;
+        return transients[(size_t) juce::jlimit (0, numTransients - 1, n - 1)];
+    }
+
+    static float gainForLoudness (float lufs);
+
+    // Reads the cached analysis for the sample's file, or analyses it and
+    // caches the result
+    static std::unique_ptr<SampleAnalysis> loadOrAnalyse (const SamplePlayer::SampleData& sample);
+    static std::unique_ptr<SampleAnalysis> analyse (const SamplePlayer::SampleData& sample);
+};
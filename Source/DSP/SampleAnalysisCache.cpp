@@ -0,0 +1,142 @@
+#include "SampleAnalysisCache.h"
+
+namespace
+{
+    constexpr int magic = 0x43415350;  // "PSAC"
+    constexpr int formatVersion = 1;   // bump when the analysis changes
+
+    juce::File getEntryFile (juce::uint64 key)
+    {
+        return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                   .getChildFile ("PULSE")
+                   .getChildFile ("AnalysisCache")
+                   .getChildFile (juce::String::toHexString ((juce::int64) key) + ".bin");
+    }
+
+    // FNV-1a over 64-bit words, seeded with the file size
+    class Fnv
+    {
+    public:
+        explicit Fnv (juce::int64 size) : hash ((0xcbf29ce484222325ULL ^ (juce::uint64) size) * prime) {}
+
+        void add (const juce::uint8* data, int numBytes)
+        {
+            int i = 0;
+            for (; i + 8 <= numBytes; i += 8)
+            {
+                hash ^= juce::ByteOrder::littleEndianInt64 (data + i);
+                hash *= prime;
+            }
+            for (; i < numBytes; ++i)
+            {
+                hash ^= data[i];
+                hash *= prime;
+            }
+        }
+
+        juce::uint64 get() const { return hash != 0 ? hash : 1; }
+
+    private:
+        static constexpr juce::uint64 prime = 0x100000001b3ULL;
+        juce::uint64 hash;
+    };
+}
+
+juce::uint64 SampleAnalysisCache::hashFile (const juce::File& file)
+{
+    auto stream = file.createInputStream();
+    if (stream == nullptr || ! stream->openedOk())
+        return 0;
+
+    Fnv fnv (stream->getTotalLength());
+    juce::HeapBlock<juce::uint8> block (65536);
+
+    for (;;)
+    {
+        int numRead = stream->read (block, 65536);
+        if (numRead <= 0)
+            break;
+
+        fnv.add (block, numRead);
+    }
+
+    return fnv.get();
+}
+
+juce::uint64 SampleAnalysisCache::fingerprintFile (const juce::File& file)
+{
+    auto stream = file.createInputStream();
+    if (stream == nullptr || ! stream->openedOk())
+        return 0;
+
+    constexpr int numChunks = 8;
+    constexpr int chunkSize = 4096;
+
+    // The modification time catches same-length edits between the
+    // sampled stretches, e.g. a fade in the middle of a long sample
+    auto length = stream->getTotalLength();
+    Fnv fnv (length);
+    auto modified = file.getLastModificationTime().toMilliseconds();
+    fnv.add (reinterpret_cast<const juce::uint8*> (&modified), (int) sizeof (modified));
+
+    juce::uint8 block[chunkSize];
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        auto start = juce::jmax ((juce::int64) 0, (length - chunkSize) * i / (numChunks - 1));
+        if (! stream->setPosition (start))
+            return 0;
+
+        fnv.add (block, stream->read (block, chunkSize));
+    }
+
+    return fnv.get();
+}
+
+std::unique_ptr<SampleAnalysis> SampleAnalysisCache::load (juce::uint64 key)
+{
+    juce::MemoryBlock data;
+    if (! getEntryFile (key).loadFileAsData (data))
+        return nullptr;
+
+    juce::MemoryInputStream in (data, false);
+    if (in.readInt() != magic || in.readInt() != formatVersion || (juce::uint64) in.readInt64() != key)
+        return nullptr;
+
+    auto analysis = std::make_unique<SampleAnalysis>();
+    analysis->peak = in.readFloat();
+    analysis->rms = in.readFloat();
+    analysis->loudness = in.readFloat();
+    analysis->firstOnset = in.readInt();
+    analysis->numTransients = in.readInt();
+
+    if (analysis->numTransients < 0 || analysis->numTransients > SampleAnalysis::maxTransients
+        || in.getNumBytesRemaining() != (juce::int64) analysis->numTransients * 4)
+        return nullptr;
+
+    for (int i = 0; i < analysis->numTransients; ++i)
+        analysis->transients[(size_t) i] = in.readInt();
+
+    analysis->autoGain = SampleAnalysis::gainForLoudness (analysis->loudness);
+    return analysis;
+}
+
+void SampleAnalysisCache::store (juce::uint64 key, const SampleAnalysis& analysis)
+{
+    juce::MemoryOutputStream out;
+    out.writeInt (magic);
+    out.writeInt (formatVersion);
+    out.writeInt64 ((juce::int64) key);
+    out.writeFloat (analysis.peak);
+    out.writeFloat (analysis.rms);
+    out.writeFloat (analysis.loudness);
+    out.writeInt (analysis.firstOnset);
+    out.writeInt (analysis.numTransients);
+
+    for (int i = 0; i < analysis.numTransients; ++i)
+        out.writeInt (analysis.transients[(size_t) i]);
+
+    auto file = getEntryFile (key);
+    if (file.getParentDirectory().createDirectory())
+        file.replaceWithData (out.getData(), out.getDataSize());
+}
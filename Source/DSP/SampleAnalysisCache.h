@@ -0,0 +1,20 @@
+#pragma once
+#include "SampleAnalysis.h"
+
+// On-disk cache of SampleAnalysis results in the user's application data
+// folder. Entries are keyed by a fingerprint of the file's size, modification
+// time and a few sampled stretches of its contents, so edited files miss,
+// moves and copies that keep the time share one entry, and a hit never
+// reads the whole file.
+namespace SampleAnalysisCache
+{
+    // 64-bit hash of the whole file, or 0 if it can't be read
+    juce::uint64 hashFile (const juce::File& file);
+
+    // Cache key: the size, modification time and eight evenly spaced 4 KB
+    // stretches (first and last included), or 0 if the file can't be read
+    juce::uint64 fingerprintFile (const juce::File& file);
+
+    std::unique_ptr<SampleAnalysis> load (juce::uint64 key);
+    void store (juce::uint64 key, const SampleAnalysis& analysis);
+}
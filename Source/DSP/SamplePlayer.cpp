@@ -1,4 +1,430 @@
 #include "SamplePlayer.h"
+#include "SampleAnalysis.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+    // The kernels read through a source so that decoded float buffers and
+    // packed PCM frames share one implementation. operator[] is unchecked.
+    struct FloatSource
+    {
+        const float* data = nullptr;
+        int length = 0;
+
+        float operator[] (int i) const { return data[i]; }
+    };
+
+    // A stretch of packed frames already converted to float: frame i of the
+    // sample is data[i - first]. The kernels only read frames inside the
+    // sample, and the stretch covers every one the span being rendered reads.
+    struct WindowSource
+    {
+        const float* data = nullptr;
+        int first = 0;
+        int length = 0;   // of the whole sample
+
+        float operator[] (int i) const { return data[i - first]; }
+    };
+
+    // Packed frames, converted to float a frame at a time (convertPcm runs
+    // one over a whole stretch)
+    template <PcmView::Encoding encoding, bool bigEndian>
+    struct PcmSource
+    {
+        const juce::uint8* data = nullptr;
+        int stride = 0;
+        int length = 0;
+
+        float operator[] (int i) const
+        {
+            const auto* p = data + (size_t) i * (size_t) stride;
+
+            if constexpr (encoding == PcmView::Encoding::Int16)
+            {
+                auto v = bigEndian ? juce::ByteOrder::bigEndianShort (p) : juce::ByteOrder::littleEndianShort (p);
+                return (float) (juce::int16) v * (1.0f / 32768.0f);
+            }
+            else if constexpr (encoding == PcmView::Encoding::Int24)
+            {
+                auto v = bigEndian ? juce::ByteOrder::bigEndian24Bit (p) : juce::ByteOrder::littleEndian24Bit (p);
+                return (float) v * (1.0f / 8388608.0f);
+            }
+            else if constexpr (encoding == PcmView::Encoding::Int32)
+            {
+                auto v = bigEndian ? juce::ByteOrder::bigEndianInt (p) : juce::ByteOrder::littleEndianInt (p);
+                return (float) (juce::int32) v * (1.0f / 2147483648.0f);
+            }
+            else
+            {
+                auto bits = bigEndian ? juce::ByteOrder::bigEndianInt (p) : juce::ByteOrder::littleEndianInt (p);
+                float v;
+                std::memcpy (&v, &bits, sizeof (v));
+                return v;
+            }
+        }
+    };
+
+    // Reads outside the sample return silence, so the wider kernels can run
+    // right up to both ends of the buffer.
+    template <typename Source>
+    float sampleAt (const Source& src, int index)
+    {
+        return juce::isPositiveAndBelow (index, src.length) ? src[index] : 0.0f;
+    }
+
+    struct LinearInterpolator
+    {
+        template <typename Source>
+        static float read (const Source& src, int idx, float frac)
+        {
+            if (idx < 0)
+                return 0.0f;
+            if (idx + 1 >= src.length)
+                return src[juce::jmin (idx, src.length - 1)];
+
+            return src[idx] * (1.0f - frac) + src[idx + 1] * frac;
+        }
+    };
+
+    struct HermiteInterpolator
+    {
+        template <typename Source>
+        static float read (const Source& src, int idx, float frac)
+        {
+            float xm1, x0, x1, x2;
+
+            if (idx >= 1 && idx + 2 < src.length)
+            {
+                xm1 = src[idx - 1];
+                x0  = src[idx];
+                x1  = src[idx + 1];
+                x2  = src[idx + 2];
+            }
+            else
+            {
+                xm1 = sampleAt (src, idx - 1);
+                x0  = sampleAt (src, idx);
+                x1  = sampleAt (src, idx + 1);
+                x2  = sampleAt (src, idx + 2);
+            }
+
+            float c1 = 0.5f * (x1 - xm1);
+            float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+            float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+            return ((c3 * frac + c2) * frac + c1) * frac + x0;
+        }
+    };
+
+    // Kaiser-windowed sinc, tabulated at numPhases fractional offsets. Each
+    // phase also stores the difference to the next one so the kernel can be
+    // linearly interpolated between phases. The cutoff sits a little below
+    // Nyquist and is not scaled with the playback rate, so large upward
+    // transpositions can still alias slightly.
+    class SincTable
+    {
+    public:
+        static constexpr int numTaps = 16;
+        static constexpr int numPhases = 256;
+        static constexpr int leftTaps = numTaps / 2 - 1; // taps before the read index
+
+        SincTable()
+        {
+            buildTable();
+        }
+
+        const float* getCoefficients (int phase) const { return coefficients.data() + phase * numTaps; }
+        const float* getDeltas (int phase) const       { return deltas.data() + phase * numTaps; }
+
+    private:
+        void buildTable()
+        {
+            constexpr double cutoff = 0.92;
+            constexpr double beta = 8.0;
+            constexpr double halfWidth = numTaps / 2;
+
+            auto besselI0 = [] (double x)
+            {
+                double sum = 1.0, term = 1.0;
+                for (int k = 1; k < 32; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+                return sum;
+            };
+
+            const double windowNorm = 1.0 / besselI0 (beta);
+
+            for (int p = 0; p <= numPhases; ++p)
+            {
+                double frac = (double) p / numPhases;
+                double sum = 0.0;
+                float* row = coefficients.data() + p * numTaps;
+
+                for (int t = 0; t < numTaps; ++t)
+                {
+                    double u = (double) (t - leftTaps) - frac;
+                    double x = juce::MathConstants<double>::pi * cutoff * u;
+                    double sinc = std::abs (x) < 1.0e-9 ? 1.0 : std::sin (x) / x;
+                    double w = u / halfWidth;
+                    double window = std::abs (w) >= 1.0 ? 0.0
+                                  : besselI0 (beta * std::sqrt (1.0 - w * w)) * windowNorm;
+
+                    row[t] = (float) (cutoff * sinc * window);
+                    sum += row[t];
+                }
+
+                // Normalise each phase to unity DC gain
+                for (int t = 0; t < numTaps; ++t)
+                    row[t] = (float) (row[t] / sum);
+            }
+
+            for (int p = 0; p < numPhases; ++p)
+                for (int t = 0; t < numTaps; ++t)
+                    deltas[(size_t) (p * numTaps + t)] = coefficients[(size_t) ((p + 1) * numTaps + t)]
+                                                       - coefficients[(size_t) (p * numTaps + t)];
+        }
+
+        alignas (16) std::array<float, numTaps * (numPhases + 1)> coefficients {};
+        alignas (16) std::array<float, numTaps * numPhases> deltas {};
+    };
+
+    // Built once at load time and shared by every player in the process
+    const SincTable sincTable;
+
+    struct SincInterpolator
+    {
+        template <typename Source>
+        static float read (const Source& src, int idx, float frac)
+        {
+            constexpr int numTaps = SincTable::numTaps;
+            constexpr int leftTaps = SincTable::leftTaps;
+
+            float taps[numTaps];
+            const float* x = taps;
+
+            if (idx >= leftTaps && idx + (numTaps - leftTaps) <= src.length)
+            {
+                if constexpr (std::is_same_v<Source, WindowSource>)
+                    x = src.data + (idx - leftTaps - src.first);
+                else
+                    x = src.data + idx - leftTaps;
+            }
+            else
+            {
+                for (int t = 0; t < numTaps; ++t)
+                    taps[t] = sampleAt (src, idx - leftTaps + t);
+            }
+
+            float phasePos = frac * (float) SincTable::numPhases;
+            int phase = juce::jmin ((int) phasePos, SincTable::numPhases - 1);
+            float phaseFrac = phasePos - (float) phase;
+
+            const float* c = sincTable.getCoefficients (phase);
+            const float* d = sincTable.getDeltas (phase);
+
+            // Four independent accumulators keep the taps in one SIMD register
+            // per group of four; the compiler turns this into packed mul/adds.
+            float acc[4] = {};
+            for (int t = 0; t < numTaps; t += 4)
+                for (int k = 0; k < 4; ++k)
+                    acc[k] += x[t + k] * (c[t + k] + phaseFrac * d[t + k]);
+
+            return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        }
+    };
+
+    struct Playhead
+    {
+        double position;
+        double rate;
+        float gain;
+    };
+
+    // Renders until the block is full or the sample ends; returns the number
+    // of samples written
+    template <typename Interpolator, typename Source, int NumChannels>
+    int renderSpan (float* const* outputs, int numSamples, const Source* sources, Playhead& playhead)
+    {
+        const int length = sources[0].length;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            if (playhead.position >= length - 1)
+                return i;
+
+            int idx = (int) playhead.position;
+            float frac = (float) (playhead.position - idx);
+
+            for (int ch = 0; ch < NumChannels; ++ch)
+                outputs[ch][i] = Interpolator::read (sources[ch], idx, frac) * playhead.gain;
+
+            playhead.position += playhead.rate;
+        }
+
+        return numSamples;
+    }
+
+    template <typename Source, int NumChannels>
+    int renderWithInterpolation (SamplePlayer::Interpolation interpolation, float* const* outputs, int numSamples,
+                                 const Source* sources, Playhead& playhead)
+    {
+        switch (interpolation)
+        {
+            case SamplePlayer::Interpolation::Linear:  return renderSpan<LinearInterpolator, Source, NumChannels> (outputs, numSamples, sources, playhead);
+            case SamplePlayer::Interpolation::Hermite: return renderSpan<HermiteInterpolator, Source, NumChannels> (outputs, numSamples, sources, playhead);
+            case SamplePlayer::Interpolation::Sinc:    return renderSpan<SincInterpolator, Source, NumChannels> (outputs, numSamples, sources, playhead);
+        }
+
+        return 0;
+    }
+
+    template <typename Source>
+    int renderChannels (SamplePlayer::Interpolation interpolation, float* const* outputs, int numSamples,
+                        const Source* sources, int numChannels, Playhead& playhead)
+    {
+        return numChannels == 2 ? renderWithInterpolation<Source, 2> (interpolation, outputs, numSamples, sources, playhead)
+                                : renderWithInterpolation<Source, 1> (interpolation, outputs, numSamples, sources, playhead);
+    }
+
+    // Packed frames are converted a stretch at a time into scratch buffers,
+    // each frame once, so the kernels read plain floats rather than
+    // converting every tap of every output sample
+    int renderPcm (SamplePlayer::Interpolation interpolation, float* const* outputs, int numSamples,
+                   const SamplePlayer::SampleData& sample, Playhead& playhead)
+    {
+        constexpr int windowSize = 512;
+        constexpr int kernelReach = SincTable::numTaps + 4;   // widest kernel, plus rounding
+
+        float scratch[2][windowSize];
+        float* scratchChannels[2] = { scratch[0], scratch[1] };
+        const int maxSpan = juce::jmax (1, (int) ((windowSize - kernelReach) / playhead.rate));
+
+        int done = 0;
+        while (done < numSamples)
+        {
+            int num = juce::jmin (numSamples - done, maxSpan);
+            int first = juce::jmax (0, (int) playhead.position - SincTable::leftTaps);
+            int last = (int) (playhead.position + playhead.rate * (num - 1)) + (SincTable::numTaps - SincTable::leftTaps);
+            int end = juce::jmin (sample.numFrames, last + 1);
+
+            if (end > first)
+                sample.readFrames (first, end - first, scratchChannels);
+
+            WindowSource sources[2] = { { scratch[0], first, sample.numFrames },
+                                        { scratch[1], first, sample.numFrames } };
+            float* spanOutputs[2] = { outputs[0] + done, sample.numChannels > 1 ? outputs[1] + done : nullptr };
+
+            int rendered = renderChannels (interpolation, spanOutputs, num, sources, sample.numChannels, playhead);
+            done += rendered;
+
+            if (rendered < num)
+                break;
+        }
+
+        return done;
+    }
+
+    // Decodes the reader into little-endian interleaved int16 or packed 24-bit
+    // frames for Storage::Compact. Works in chunks so the float copy of the
+    // whole file never exists.
+    void packFrames (juce::AudioFormatReader& reader, SamplePlayer::SampleData& sample, PcmView::Encoding encoding)
+    {
+        const int numChannels = sample.numChannels;
+        const int numFrames = (int) reader.lengthInSamples;
+        const int bytes = PcmView::bytesPerSample (encoding);
+        const int frameStride = bytes * numChannels;
+        const float scale = encoding == PcmView::Encoding::Int16 ? 32767.0f : 8388607.0f;
+
+        sample.packedSize = (size_t) numFrames * (size_t) frameStride;
+        sample.packed.malloc (sample.packedSize);
+
+        constexpr int chunkSize = 8192;
+        juce::AudioBuffer<float> chunk (numChannels, chunkSize);
+
+        for (int start = 0; start < numFrames; start += chunkSize)
+        {
+            int num = juce::jmin (chunkSize, numFrames - start);
+            reader.read (&chunk, 0, num, start, true, numChannels > 1);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                const float* src = chunk.getReadPointer (ch);
+                juce::uint8* dest = sample.packed + (size_t) start * (size_t) frameStride + (size_t) (ch * bytes);
+
+                for (int i = 0; i < num; ++i, dest += frameStride)
+                {
+                    auto v = (juce::uint32) juce::roundToInt (juce::jlimit (-1.0f, 1.0f, src[i]) * scale);
+                    dest[0] = (juce::uint8) v;
+                    dest[1] = (juce::uint8) (v >> 8);
+                    if (bytes == 3)
+                        dest[2] = (juce::uint8) (v >> 16);
+                }
+            }
+        }
+
+        sample.numFrames = numFrames;
+        sample.pcm.data = sample.packed;
+        sample.pcm.encoding = encoding;
+        sample.pcm.bigEndian = false;
+        sample.pcm.frameStride = frameStride;
+        sample.pcm.channelStride = bytes;
+    }
+
+    template <PcmView::Encoding encoding, bool bigEndian>
+    void convertPcm (const SamplePlayer::SampleData& sample, int startFrame, int numToRead, float* const* dest)
+    {
+        for (int ch = 0; ch < sample.numChannels; ++ch)
+        {
+            PcmSource<encoding, bigEndian> source { sample.pcm.data + ch * sample.pcm.channelStride,
+                                                    sample.pcm.frameStride, sample.numFrames };
+            for (int i = 0; i < numToRead; ++i)
+                dest[ch][i] = source[startFrame + i];
+        }
+    }
+
+    template <PcmView::Encoding encoding>
+    void convertPcm (const SamplePlayer::SampleData& sample, int startFrame, int numToRead, float* const* dest)
+    {
+        if (sample.pcm.bigEndian)
+            convertPcm<encoding, true> (sample, startFrame, numToRead, dest);
+        else
+            convertPcm<encoding, false> (sample, startFrame, numToRead, dest);
+    }
+
+    // Mapped samples up to this size are copied to the heap when their pages
+    // can't be locked
+    constexpr size_t maxUnlockedCopyBytes = 16 * 1024 * 1024;
+
+    // Returns N for a "<prefix><N>" token in the file name (e.g. "_v2",
+    // "-rr3"), or 0 when there is none
+    int zoneNumber (const juce::File& file, const juce::String& prefix)
+    {
+        auto tokens = juce::StringArray::fromTokens (file.getFileNameWithoutExtension().toLowerCase(), "_- .", {});
+
+        for (auto& token : tokens)
+            if (token.startsWith (prefix) && token.length() > prefix.length()
+                && token.substring (prefix.length()).containsOnly ("0123456789"))
+                return token.substring (prefix.length()).getIntValue();
+
+        return 0;
+    }
+
+    int renderSample (SamplePlayer::Interpolation interpolation, float* const* outputs, int numSamples,
+                      const SamplePlayer::SampleData& sample, Playhead& playhead)
+    {
+        if (sample.pcm.isValid())
+            return renderPcm (interpolation, outputs, numSamples, sample, playhead);
+
+        FloatSource sources[2];
+        for (int ch = 0; ch < sample.numChannels; ++ch)
+            sources[ch] = { sample.buffer.getReadPointer (ch), sample.numFrames };
+
+        return renderChannels (interpolation, outputs, numSamples, sources, sample.numChannels, playhead);
+    }
+}
 
 void SamplePlayer::prepare (double sampleRate)
 {
@@ -9,13 +435,41 @@ void SamplePlayer::prepare (double sampleRate)
 
 void SamplePlayer::trigger (float velocity)
 {
-    auto sample = std::atomic_load (&currentSample);
-    if (sample == nullptr || sample->buffer.getNumSamples() == 0)
+    const auto* zoneMap = blockZones;
+    if (zoneMap == nullptr)
+        return;
+
+    // Velocity picks the layer through a lookup table, then the layer's
+    // round-robin counter picks the sample
+    int midiVelocity = juce::jlimit (0, 127, juce::roundToInt (velocity * 127.0f));
+    int layerIndex = zoneMap->layerForVelocity[(size_t) midiVelocity];
+    const auto& layer = zoneMap->layers[(size_t) layerIndex];
+    auto step = roundRobinSteps[(size_t) layerIndex]++;
+    int zone = layer.firstSample + (int) (step % (juce::uint32) layer.numRoundRobins);
+
+    const auto& sample = zoneMap->samples[(size_t) zone];
+    if (sample->numFrames == 0)
         return;
 
+    // Start points come from the precomputed analysis once it's available
+    double startFrame = startPos * sample->numFrames;
+    zoneGain = 1.0f;
+
+    if (const auto* analysis = sample->analysis.load (std::memory_order_acquire))
+    {
+        if (autoGain)
+            zoneGain = analysis->autoGain;
+
+        if (transient > 0)
+            startFrame = analysis->getTransient (transient);
+        else if (autoTrim)
+            startFrame = analysis->firstOnset + startPos * (sample->numFrames - analysis->firstOnset);
+    }
+
+    currentZone = zone;
     currentVelocity = velocity;
     playbackRate = (sample->sampleRate / hostSampleRate) * std::pow (2.0, tune / 12.0);
-    position = startPos * sample->buffer.getNumSamples();
+    position = startFrame;
     playing = true;
 }
 
@@ -24,111 +478,429 @@ void SamplePlayer::stop()
     playing = false;
 }
 
-bool SamplePlayer::processBlock (float* output, int numSamples)
+void SamplePlayer::switchBlockZones (const ZoneMap* zoneMap) noexcept
+{
+    // The same files in the same order: currentZone is still the same sound
+    if (zoneMap == nullptr || blockZones == nullptr || zoneMap->paths != blockZones->paths)
+        stop();
+
+    blockZones = zoneMap;
+}
+
+int SamplePlayer::processBlock (float* left, float* right, int numSamples)
 {
     if (! playing)
     {
-        juce::FloatVectorOperations::clear (output, numSamples);
-        return false;
+        juce::FloatVectorOperations::clear (left, numSamples);
+        return 0;
     }
 
-    auto sample = std::atomic_load (&currentSample);
-    if (sample == nullptr)
+    // If the zones were swapped mid-note, carry on with the same zone of the
+    // new set while it exists
+    const auto* zoneMap = blockZones;
+    if (zoneMap == nullptr || currentZone >= (int) zoneMap->samples.size())
     {
         playing = false;
-        juce::FloatVectorOperations::clear (output, numSamples);
-        return false;
+        juce::FloatVectorOperations::clear (left, numSamples);
+        return 0;
     }
 
-    const float* data = sample->buffer.getReadPointer (0);
-    int sampleLength = sample->buffer.getNumSamples();
+    const auto& sample = zoneMap->samples[(size_t) currentZone];
 
     // Recalculate playback rate in case tune changed
     playbackRate = (sample->sampleRate / hostSampleRate) * std::pow (2.0, tune / 12.0);
 
-    for (int i = 0; i < numSamples; ++i)
+    float* outputs[2] = { left, right };
+    Playhead playhead { position, playbackRate, level * currentVelocity * zoneGain };
+    int rendered = renderSample (interpolation, outputs, numSamples, *sample, playhead);
+    position = playhead.position;
+
+    if (rendered < numSamples)
+    {
+        playing = false;
+        for (int ch = 0; ch < sample->numChannels; ++ch)
+            juce::FloatVectorOperations::clear (outputs[ch] + rendered, numSamples - rendered);
+    }
+
+    return sample->numChannels;
+}
+
+std::shared_ptr<SamplePlayer::SampleData> SamplePlayer::createSampleData (const juce::File& file,
+                                                                       juce::AudioFormatManager& formatManager,
+                                                                       Storage storage)
+{
+    auto reader = std::unique_ptr<juce::AudioFormatReader> (formatManager.createReaderFor (file));
+    if (reader == nullptr)
+        return nullptr;
+
+    auto newSample = std::make_shared<SampleData>();
+    int numChannels = (int) reader->numChannels;
+
+    // Keep mono files mono and stereo files stereo; anything wider is
+    // reduced to its first two channels.
+    newSample->numChannels = juce::jmin (numChannels, 2);
+    newSample->sampleRate = reader->sampleRate;
+    newSample->file = file;
+
+    if (storage == Storage::MemoryMapped)
     {
-        if (position >= sampleLength - 1)
+        if (auto mapped = MappedSampleFile::open (file))
         {
-            playing = false;
-            for (int j = i; j < numSamples; ++j)
-                output[j] = 0.0f;
-            return i > 0; // was playing for part of the block
+            // Only play in place if our header parse agrees with the reader.
+            // Pages that can't be locked can be evicted and fault on the
+            // audio thread later, so short one-shots get a resident copy
+            // instead; long samples still play mapped, prefaulted only.
+            bool agrees = mapped->getNumChannels() == numChannels && mapped->getNumFrames() == reader->lengthInSamples;
+            bool playInPlace = agrees && (mapped->lockPages() || mapped->getMappedSize() > maxUnlockedCopyBytes);
+
+            if (playInPlace)
+            {
+                mapped->prefault();
+                newSample->pcm = mapped->getFrames();
+                newSample->numFrames = (int) mapped->getNumFrames();
+                newSample->mappedFile = std::move (mapped);
+            }
         }
+    }
+    else if (storage == Storage::Compact && ! reader->usesFloatingPointData)
+    {
+        packFrames (*reader, *newSample, reader->bitsPerSample <= 16 ? PcmView::Encoding::Int16
+                                                                      : PcmView::Encoding::Int24);
+    }
 
-        output[i] = interpolate (position, data, sampleLength) * level * currentVelocity;
-        position += playbackRate;
+    if (! newSample->pcm.isValid())
+    {
+        int numSamples = (int) reader->lengthInSamples;
+        newSample->numFrames = numSamples;
+        newSample->buffer.setSize (newSample->numChannels, numSamples);
+        reader->read (&newSample->buffer, 0, numSamples, 0, true, numChannels > 1);
     }
 
-    return true;
+    return newSample;
 }
 
-float SamplePlayer::interpolate (double pos, const float* data, int length) const
+// Decodes one slot's files on a worker thread and publishes the result
+// unless a newer load for the same slot was requested meanwhile
+class SamplePlayer::LoadJob : public juce::ThreadPoolJob
 {
-    int idx = (int) pos;
-    float frac = (float) (pos - idx);
+public:
+    LoadJob (SamplePlayer& p, juce::Array<juce::File> filesToLoad, juce::StringArray sourcesOfFiles,
+             juce::AudioFormatManager& fm, juce::uint32 generationToPublish, std::function<void()> callback)
+        : juce::ThreadPoolJob ("PULSE sample load"),
+          owner (p), files (std::move (filesToLoad)), sources (std::move (sourcesOfFiles)), formatManager (fm),
+          storage (p.storage), generation (generationToPublish), onLoaded (std::move (callback))
+    {
+    }
 
-    if (idx < 0)
-        return 0.0f;
-    if (idx + 1 >= length)
-        return data[juce::jmin (idx, length - 1)];
+    JobStatus runJob() override
+    {
+        auto newZones = owner.createZones (files, sources, formatManager, storage, this);
 
-    return data[idx] * (1.0f - frac) + data[idx + 1] * frac;
+        if (! shouldExit())
+        {
+            owner.publishZones (std::move (newZones), generation);
+
+            if (onLoaded != nullptr)
+                onLoaded();
+        }
+
+        return jobHasFinished;
+    }
+
+    SamplePlayer& owner;
+
+private:
+    juce::Array<juce::File> files;
+    juce::StringArray sources;
+    juce::AudioFormatManager& formatManager;
+    Storage storage;
+    juce::uint32 generation;
+    std::function<void()> onLoaded;
+};
+
+SamplePlayer::~SamplePlayer()
+{
+    cancelPendingLoads();
 }
 
 void SamplePlayer::loadSample (const juce::File& file, juce::AudioFormatManager& formatManager)
 {
-    auto reader = std::unique_ptr<juce::AudioFormatReader> (formatManager.createReaderFor (file));
-    if (reader == nullptr)
+    loadZones ({ file }, formatManager);
+}
+
+void SamplePlayer::loadZones (const juce::Array<juce::File>& files, juce::AudioFormatManager& formatManager)
+{
+    auto generation = requestLoad (files, {});
+    publishZones (createZones (files, {}, formatManager, storage), generation);
+}
+
+std::shared_ptr<const SamplePlayer::ZoneMap> SamplePlayer::createZones (const juce::Array<juce::File>& files,
+                                                                      const juce::StringArray& sources,
+                                                                      juce::AudioFormatManager& formatManager,
+                                                                      Storage storage, const juce::ThreadPoolJob* job)
+{
+    struct Entry
+    {
+        int layer, roundRobin;
+        juce::File file, source;
+        std::shared_ptr<const SampleData> data;
+    };
+
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+    std::vector<Entry> entries;
+
+    for (int i = 0; i < files.size(); ++i)
+    {
+        if (job != nullptr && job->shouldExit())
+            return nullptr;
+
+        // Zones are named and ordered by the source, so an embedded copy
+        // sorts where its original did
+        auto file = files[i];
+        auto source = sources[i].isNotEmpty() ? juce::File (sources[i]) : file;
+
+        if (auto data = createSampleData (file, formatManager, storage))
+        {
+            std::shared_ptr<const SampleData> sample (std::move (data));
+            workerPool->addJob ([sample] { sample->setAnalysis (SampleAnalysis::loadOrAnalyse (*sample)); });
+            entries.push_back ({ zoneNumber (source, "v"), zoneNumber (source, "rr"), file, source, std::move (sample) });
+        }
+    }
+
+    if (entries.empty())
+        return nullptr;
+
+    std::stable_sort (entries.begin(), entries.end(), [] (const Entry& a, const Entry& b)
+    {
+        if (a.layer != b.layer)
+            return a.layer < b.layer;
+        if (a.roundRobin != b.roundRobin)
+            return a.roundRobin < b.roundRobin;
+        return a.source.getFileName() < b.source.getFileName();
+    });
+
+    auto newZones = std::make_shared<ZoneMap>();
+    juce::StringArray paths, sourcePaths;
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (i == 0 || entries[i].layer != entries[i - 1].layer)
+            newZones->layers.push_back ({ (int) newZones->samples.size(), 0 });
+
+        newZones->layers.back().numRoundRobins++;
+        newZones->samples.push_back (entries[i].data);
+        paths.add (entries[i].file.getFullPathName());
+        sourcePaths.add (entries[i].source.getFullPathName());
+    }
+
+    // Spread the layers evenly over the velocity range, softest first
+    int numLayers = juce::jmin ((int) newZones->layers.size(), 128);
+    newZones->layers.resize ((size_t) numLayers);
+    for (int v = 0; v < 128; ++v)
+        newZones->layerForVelocity[(size_t) v] = (juce::uint8) (v * numLayers / 128);
+
+    newZones->displayName = entries.size() == 1 ? entries[0].source.getFileName()
+                                                : entries[0].source.getFileName() + " (+" + juce::String ((int) entries.size() - 1) + ")";
+    newZones->paths = paths.joinIntoString ("\n");
+    newZones->sourcePaths = sourcePaths.joinIntoString ("\n");
+
+    return newZones;
+}
+
+juce::uint32 SamplePlayer::requestLoad (const juce::Array<juce::File>& files, const juce::StringArray& sources)
+{
+    juce::StringArray paths, sourcePaths;
+    for (int i = 0; i < files.size(); ++i)
+    {
+        paths.add (files[i].getFullPathName());
+        sourcePaths.add (sources[i].isNotEmpty() ? sources[i] : paths[i]);
+    }
+
+    const juce::ScopedLock sl (loadLock);
+    pendingPaths = paths.joinIntoString ("\n");
+    pendingSourcePaths = sourcePaths.joinIntoString ("\n");
+    return ++loadGeneration;
+}
+
+void SamplePlayer::publishZones (std::shared_ptr<const ZoneMap> newZones, juce::uint32 generation)
+{
+    const juce::ScopedLock sl (loadLock);
+
+    // A newer request owns the slot now
+    if (generation != loadGeneration)
         return;
 
-    auto newSample = std::make_shared<SampleData>();
-    int numChannels = (int) reader->numChannels;
-    int numSamples = (int) reader->lengthInSamples;
+    // If nothing could be loaded the previous zones stay
+    if (newZones != nullptr)
+        zones.publish (std::move (newZones));
 
-    // Read as mono (mix down if stereo)
-    newSample->buffer.setSize (1, numSamples);
+    pendingPaths.clear();
+    pendingSourcePaths.clear();
+}
+
+void SamplePlayer::cancelPendingLoads()
+{
+    struct OwnJobs : public juce::ThreadPool::JobSelector
+    {
+        explicit OwnJobs (SamplePlayer& p) : player (p) {}
+
+        bool isJobSuitable (juce::ThreadPoolJob* job) override
+        {
+            auto* load = dynamic_cast<LoadJob*> (job);
+            return load != nullptr && &load->owner == &player;
+        }
 
-    if (numChannels == 1)
+        SamplePlayer& player;
+    };
+
+    // No timeout: a running job refers to this player (and to the caller's
+    // format manager and callback), so it must be finished before any of
+    // them can go. It stops at the end of the file it is decoding.
+    OwnJobs selector (*this);
+    workerPool->removeAllJobs (true, -1, &selector);
+}
+
+juce::String SamplePlayer::getFileName() const
+{
+    auto zoneMap = zones.get();
+    return zoneMap != nullptr ? zoneMap->displayName : juce::String();
+}
+
+juce::String SamplePlayer::getFilePath() const
+{
     {
-        reader->read (&newSample->buffer, 0, numSamples, 0, true, false);
+        const juce::ScopedLock sl (loadLock);
+        if (pendingPaths.isNotEmpty())
+            return pendingPaths;
     }
-    else
+
+    auto zoneMap = zones.get();
+    return zoneMap != nullptr ? zoneMap->paths : juce::String();
+}
+
+juce::String SamplePlayer::getSourcePath() const
+{
     {
-        juce::AudioBuffer<float> tempBuf (numChannels, numSamples);
-        reader->read (&tempBuf, 0, numSamples, 0, true, true);
+        const juce::ScopedLock sl (loadLock);
+        if (pendingPaths.isNotEmpty())
+            return pendingSourcePaths;
+    }
 
-        auto* mono = newSample->buffer.getWritePointer (0);
-        for (int i = 0; i < numSamples; ++i)
+    auto zoneMap = zones.get();
+    return zoneMap != nullptr ? zoneMap->sourcePaths : juce::String();
+}
+
+SamplePlayer::SampleData::~SampleData()
+{
+    delete analysis.load();
+}
+
+void SamplePlayer::SampleData::readFrames (int startFrame, int numToRead, float* const* dest) const
+{
+    if (pcm.isValid())
+    {
+        switch (pcm.encoding)
         {
-            float sum = 0.0f;
-            for (int ch = 0; ch < numChannels; ++ch)
-                sum += tempBuf.getSample (ch, i);
-            mono[i] = sum / (float) numChannels;
+            case PcmView::Encoding::Int16:   convertPcm<PcmView::Encoding::Int16> (*this, startFrame, numToRead, dest); break;
+            case PcmView::Encoding::Int24:   convertPcm<PcmView::Encoding::Int24> (*this, startFrame, numToRead, dest); break;
+            case PcmView::Encoding::Int32:   convertPcm<PcmView::Encoding::Int32> (*this, startFrame, numToRead, dest); break;
+            case PcmView::Encoding::Float32: convertPcm<PcmView::Encoding::Float32> (*this, startFrame, numToRead, dest); break;
         }
+        return;
     }
 
-    newSample->sampleRate = reader->sampleRate;
-    newSample->fileName = file.getFileName();
-    loadedFilePath = file.getFullPathName();
+    for (int ch = 0; ch < numChannels; ++ch)
+        juce::FloatVectorOperations::copy (dest[ch], buffer.getReadPointer (ch, startFrame), numToRead);
+}
 
-    std::atomic_store (&currentSample, newSample);
+void SamplePlayer::SampleData::setAnalysis (std::unique_ptr<SampleAnalysis> newAnalysis) const
+{
+    const SampleAnalysis* expected = nullptr;
+    if (analysis.compare_exchange_strong (expected, newAnalysis.get(), std::memory_order_release))
+        newAnalysis.release();
 }
 
-juce::String SamplePlayer::getFileName() const
+size_t SamplePlayer::SampleData::getHeapBytes() const
 {
-    auto sample = std::atomic_load (&currentSample);
-    if (sample != nullptr)
-        return sample->fileName;
-    return {};
+    return (size_t) buffer.getNumChannels() * (size_t) buffer.getNumSamples() * sizeof (float) + packedSize;
 }
 
-void SamplePlayer::loadFromPath (const juce::String& path, juce::AudioFormatManager& formatManager)
+size_t SamplePlayer::SampleData::getMappedBytes() const
 {
-    if (path.isNotEmpty())
+    return mappedFile != nullptr ? mappedFile->getMappedSize() : 0;
+}
+
+SamplePlayer::MemoryUsage SamplePlayer::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    if (auto zoneMap = zones.get())
     {
-        juce::File file (path);
-        if (file.existsAsFile())
-            loadSample (file, formatManager);
+        for (auto& sample : zoneMap->samples)
+        {
+            usage.heapBytes += sample->getHeapBytes();
+            usage.mappedBytes += sample->getMappedBytes();
+        }
+    }
+    return usage;
+}
+
+juce::Array<juce::File> SamplePlayer::filesFromPath (const juce::String& path, const juce::String& sourcePath,
+                                                     juce::StringArray& sources)
+{
+    auto lines = juce::StringArray::fromLines (path);
+    auto sourceLines = juce::StringArray::fromLines (sourcePath);
+
+    juce::Array<juce::File> files;
+    sources.clear();
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        juce::File file (lines[i]);
+        if (lines[i].isNotEmpty() && file.existsAsFile())
+        {
+            files.add (file);
+            sources.add (sourceLines[i]);
+        }
     }
+    return files;
+}
+
+void SamplePlayer::loadFromPath (const juce::String& path, juce::AudioFormatManager& formatManager)
+{
+    juce::StringArray sources;
+    auto files = filesFromPath (path, {}, sources);
+
+    if (! files.isEmpty())
+        loadZones (files, formatManager);
+}
+
+std::shared_ptr<const SamplePlayer::ZoneMap> SamplePlayer::createZonesFromPath (const juce::String& path,
+                                                                               juce::AudioFormatManager& formatManager,
+                                                                               Storage storage, const juce::String& sourcePath)
+{
+    juce::StringArray sources;
+    auto files = filesFromPath (path, sourcePath, sources);
+    return files.isEmpty() ? nullptr : createZones (files, sources, formatManager, storage);
+}
+
+void SamplePlayer::setZones (std::shared_ptr<const ZoneMap> newZones)
+{
+    const juce::ScopedLock sl (loadLock);
+
+    ++loadGeneration;
+    pendingPaths.clear();
+    pendingSourcePaths.clear();
+    zones.publish (std::move (newZones));
+}
+
+void SamplePlayer::loadFromPathAsync (const juce::String& path, juce::AudioFormatManager& formatManager,
+                                      std::function<void()> onLoaded, const juce::String& sourcePath)
+{
+    juce::StringArray sources;
+    auto files = filesFromPath (path, sourcePath, sources);
+    if (files.isEmpty())
+        return;
+
+    auto generation = requestLoad (files, sources);
+    workerPool->addJob (new LoadJob (*this, files, sources, formatManager, generation, std::move (onLoaded)), true);
 }
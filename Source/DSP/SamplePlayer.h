@@ -1,44 +1,192 @@
 #pragma once
 #include <juce_audio_formats/juce_audio_formats.h>
+#include "MappedSampleFile.h"
+#include "../Utility/RcuHandle.h"
+#include "../Utility/WorkerPool.h"
+
+struct SampleAnalysis;
 
 class SamplePlayer
 {
 public:
     struct SampleData
     {
+        // The audio lives either in buffer (decoded float) or, when pcm is
+        // valid, in packed frames held by mappedFile or packed
         juce::AudioBuffer<float> buffer;
+        PcmView pcm;
+        std::unique_ptr<MappedSampleFile> mappedFile;
+        juce::HeapBlock<juce::uint8> packed;
+        size_t packedSize = 0;
+
+        int numChannels = 1;   // 1 for mono files, 2 for stereo
+        int numFrames = 0;
         double sampleRate = 44100.0;
-        juce::String fileName;
+        juce::File file;
+
+        // Filled in once by a background job after loading; null until then
+        mutable std::atomic<const SampleAnalysis*> analysis { nullptr };
+
+        ~SampleData();
+
+        // Converts frames to float from whichever storage holds them
+        void readFrames (int startFrame, int numToRead, float* const* dest) const;
+
+        void setAnalysis (std::unique_ptr<SampleAnalysis> newAnalysis) const;
+
+        size_t getHeapBytes() const;
+        size_t getMappedBytes() const;
+    };
+
+    // Decoded holds 32-bit float. MemoryMapped plays uncompressed WAV/AIFF
+    // straight from the file's pages. Compact holds int16, or packed 24-bit
+    // for deeper sources (float files stay Decoded). Mapped and Compact fall
+    // back to Decoded for anything they can't handle.
+    enum class Storage { Decoded, MemoryMapped, Compact };
+
+    // A slot's zones: velocity layers, each with a group of round-robin
+    // samples. Built and preloaded on the message thread, then published
+    // atomically as one immutable object.
+    struct ZoneMap
+    {
+        struct Layer
+        {
+            int firstSample = 0;     // index into samples
+            int numRoundRobins = 0;
+        };
+
+        std::vector<std::shared_ptr<const SampleData>> samples;
+        std::vector<Layer> layers;                     // softest first
+        std::array<juce::uint8, 128> layerForVelocity {}; // MIDI velocity -> layer
+
+        juce::String displayName;
+        juce::String paths;         // newline-separated
+        juce::String sourcePaths;   // line for line with paths: where each
+                                    // sample came from, e.g. the original of
+                                    // an embedded copy; what state saves
+    };
+
+    struct MemoryUsage
+    {
+        size_t heapBytes = 0;     // private to this instance
+        size_t mappedBytes = 0;   // backed by the shared page cache
     };
 
+    // Linear is the cheapest, Hermite is a 4-point cubic, Sinc is a 16-tap
+    // windowed-sinc read from a shared polyphase table.
+    enum class Interpolation { Linear, Hermite, Sinc };
+
+    SamplePlayer() = default;
+    ~SamplePlayer();
+
     void prepare (double sampleRate);
+
+    // Audio thread: bracket each block. trigger() and processBlock() only
+    // work in between, on the zones that were current at beginBlock().
+    void beginBlock() noexcept { blockZones = zones.beginRead(); }
+    void endBlock() noexcept { zones.endRead(); blockZones = nullptr; }
+    // Plays other zones (or none) for the rest of this block
+    void overrideBlockZones (const ZoneMap* zoneMap) noexcept { blockZones = zoneMap; }
+    // As overrideBlockZones, for a kit switch: a note ringing from other
+    // files is stopped rather than carried into a zone of the new set
+    void switchBlockZones (const ZoneMap* zoneMap) noexcept;
+
     void trigger (float velocity);
     void stop();
-    bool processBlock (float* output, int numSamples);
+
+    // Renders into left, and into right as well when the sample is stereo.
+    // Returns the number of channels written: 1 for mono, 2 for stereo, or
+    // 0 when nothing is playing (left is cleared, right is untouched).
+    int processBlock (float* left, float* right, int numSamples);
 
     // Called from GUI/message thread
     void loadSample (const juce::File& file, juce::AudioFormatManager& formatManager);
 
+    // Loads several files as zones. Names containing "_v<N>" pick velocity
+    // layer N (layers split the velocity range evenly, lowest N softest) and
+    // "_rr<N>" orders the round-robins within a layer. Files without tokens
+    // all become round-robins of a single layer.
+    void loadZones (const juce::Array<juce::File>& files, juce::AudioFormatManager& formatManager);
+
     float level = 1.0f;
     float tune = 0.0f;       // semitones -24 to +24
     float startPos = 0.0f;   // 0.0 to 1.0
+    bool autoTrim = false;   // skip leading silence; startPos then covers the rest
+    bool autoGain = false;   // normalise each sample's loudness to a common target
+    int transient = 0;       // 0 = off, else start at analysed transient N
+    Interpolation interpolation = Interpolation::Linear;
+    Storage storage = Storage::MemoryMapped;  // applies to subsequent loads
 
-    bool isLoaded() const { return std::atomic_load (&currentSample) != nullptr; }
+    bool isLoaded() const { return zones.get() != nullptr; }
     bool isPlaying() const { return playing; }
     juce::String getFileName() const;
-    juce::String getFilePath() const { return loadedFilePath; }
+    juce::String getFilePath() const;  // newline-separated for zones; includes loads in flight
+    juce::String getSourcePath() const;  // as getFilePath, with each line's source path
+    MemoryUsage getMemoryUsage() const;
 
-    // Load from a saved path (for state restore)
+    // Load from a saved path, or newline-separated zone paths (for state restore)
     void loadFromPath (const juce::String& path, juce::AudioFormatManager& formatManager);
 
+    // As loadFromPath, but decodes on the shared worker pool. Playback keeps
+    // using the previous zones until the new ones are published; a later
+    // load of this slot supersedes it. onLoaded runs on the worker thread.
+    // sourcePath, line for line with path, records where each file stands
+    // in for (see ZoneMap::sourcePaths); by default the file itself.
+    void loadFromPathAsync (const juce::String& path, juce::AudioFormatManager& formatManager,
+                            std::function<void()> onLoaded, const juce::String& sourcePath = {});
+
+    // Drops queued async loads and waits, without a timeout, for a running
+    // one to stop; call before the player or the load's callback goes away
+    void cancelPendingLoads();
+
+    // Builds zones from a saved path without touching any slot (any thread);
+    // nullptr if none of the files could be loaded
+    static std::shared_ptr<const ZoneMap> createZonesFromPath (const juce::String& path,
+                                                               juce::AudioFormatManager& formatManager,
+                                                               Storage storage, const juce::String& sourcePath = {});
+
+    // Publishes ready-made zones, or empties the slot, superseding any load
+    // in flight (message thread)
+    void setZones (std::shared_ptr<const ZoneMap> newZones);
+
 private:
-    float interpolate (double pos, const float* data, int length) const;
+    class LoadJob;
+
+    static std::shared_ptr<SampleData> createSampleData (const juce::File& file, juce::AudioFormatManager& formatManager,
+                                                         Storage storage);
+    // sources holds each file's source path (empty for the file itself).
+    // Gives up between files once job (if any) is asked to exit.
+    static std::shared_ptr<const ZoneMap> createZones (const juce::Array<juce::File>& files,
+                                                       const juce::StringArray& sources,
+                                                       juce::AudioFormatManager& formatManager, Storage storage,
+                                                       const juce::ThreadPoolJob* job = nullptr);
+
+    // The existing files among path's lines, and their source paths
+    static juce::Array<juce::File> filesFromPath (const juce::String& path, const juce::String& sourcePath,
+                                                  juce::StringArray& sources);
 
-    std::shared_ptr<SampleData> currentSample;
+    juce::uint32 requestLoad (const juce::Array<juce::File>& files, const juce::StringArray& sources);
+    void publishZones (std::shared_ptr<const ZoneMap> newZones, juce::uint32 generation);
+
+    // Replaced zones are freed on the release pool's thread, never on the
+    // audio thread
+    RcuHandle<ZoneMap> zones;
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+    const ZoneMap* blockZones = nullptr;  // snapshot for the current block
+
+    // Guards load ordering: only the newest requested load may publish
+    mutable juce::CriticalSection loadLock;
+    juce::uint32 loadGeneration = 0;
+    juce::String pendingPaths, pendingSourcePaths;
+
+    int currentZone = 0;
+    float zoneGain = 1.0f;
+    std::array<juce::uint32, 128> roundRobinSteps {};  // per layer
     double hostSampleRate = 44100.0;
     double playbackRate = 1.0;
     double position = 0.0;
     float currentVelocity = 0.0f;
     bool playing = false;
-    juce::String loadedFilePath;
+
+    JUCE_DECLARE_NON_COPYABLE (SamplePlayer)
 };
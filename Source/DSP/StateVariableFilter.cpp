@@ -0,0 +1,80 @@
+#include "StateVariableFilter.h"
+
+void StateVariableFilter::prepare (double sampleRate)
+{
+    auto octaves = std::log2 (0.49 * sampleRate / (double) minFrequency);
+    auto size = (int) std::ceil (octaves * stepsPerOctave) + 2;
+
+    prewarpTable.resize ((size_t) size);
+    for (size_t j = 0; j < prewarpTable.size(); ++j)
+    {
+        auto frequency = juce::jmin ((double) minFrequency * std::exp2 ((double) j / stepsPerOctave), 0.49 * sampleRate);
+        prewarpTable[j] = (float) std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+    }
+
+    maxPosition = (float) (octaves * stepsPerOctave);
+    reset();
+}
+
+void StateVariableFilter::reset()
+{
+    ic1eq = 0.0f;
+    ic2eq = 0.0f;
+}
+
+void StateVariableFilter::process (float* samples, int numSamples, Mode mode, float cutoffHz, float resonance,
+                                   const float* envelope, float envelopeOctaves)
+{
+    if (prewarpTable.empty())
+        return;
+
+    auto k = 2.0f - 1.95f * juce::jlimit (0.0f, 1.0f, resonance);
+
+    // The output is a fixed mix of the three responses, chosen per block
+    auto lowMix  = mode == Mode::Lowpass ? 1.0f : 0.0f;
+    auto bandMix = mode == Mode::Bandpass ? k : 0.0f;
+    auto highMix = mode == Mode::Highpass ? 1.0f : 0.0f;
+
+    auto basePosition = std::log2 (juce::jmax (cutoffHz, minFrequency) / minFrequency) * (float) stepsPerOctave;
+    auto envelopeSteps = envelopeOctaves * (float) stepsPerOctave;
+    auto* table = prewarpTable.data();
+
+    float a1[chunkSize], a2[chunkSize], a3[chunkSize];
+    float s1 = ic1eq, s2 = ic2eq;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        auto num = juce::jmin (chunkSize, numSamples - start);
+        auto* x = samples + start;
+
+        // Per-sample coefficients, in a loop with no carried state so the
+        // division vectorises; the recursion below only multiplies and adds
+        for (int i = 0; i < num; ++i)
+        {
+            auto position = envelope != nullptr ? basePosition + envelopeSteps * envelope[start + i] : basePosition;
+            position = juce::jlimit (0.0f, maxPosition, position);
+            auto index = (int) position;
+            auto frac = position - (float) index;
+            auto g = table[index] + frac * (table[index + 1] - table[index]);
+
+            a1[i] = 1.0f / (1.0f + g * (g + k));
+            a2[i] = g * a1[i];
+            a3[i] = g * a2[i];
+        }
+
+        for (int i = 0; i < num; ++i)
+        {
+            auto v3 = x[i] - s2;
+            auto v1 = a1[i] * s1 + a2[i] * v3;
+            auto v2 = s2 + a2[i] * s1 + a3[i] * v3;
+            s1 = 2.0f * v1 - s1;
+            s2 = 2.0f * v2 - s2;
+
+            auto high = x[i] - k * v1 - v2;
+            x[i] = lowMix * v2 + bandMix * v1 + highMix * high;
+        }
+    }
+
+    ic1eq = s1;
+    ic2eq = s2;
+}
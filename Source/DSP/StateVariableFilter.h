@@ -0,0 +1,31 @@
+#pragma once
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// Topology-preserving-transform state-variable filter (Zavalishin), with a
+// cutoff that may move every sample. The tan() prewarp comes from a
+// log-spaced table prepared per sample rate, so a per-sample sweep costs a
+// lookup instead of a transcendental call.
+class StateVariableFilter
+{
+public:
+    enum class Mode { Lowpass, Bandpass, Highpass };
+
+    void prepare (double sampleRate);
+    void reset();
+
+    // Filters in place. If envelope is given, the cutoff for sample i is
+    // cutoffHz moved by envelope[i] * envelopeOctaves octaves. Resonance
+    // runs 0-1 (Q 0.5 to 20); the band-pass is normalised to unity peak gain.
+    void process (float* samples, int numSamples, Mode mode, float cutoffHz, float resonance,
+                  const float* envelope, float envelopeOctaves);
+
+private:
+    static constexpr float minFrequency = 20.0f;
+    static constexpr int stepsPerOctave = 48;
+    static constexpr int chunkSize = 64;
+
+    std::vector<float> prewarpTable;   // tan (pi f / fs) from minFrequency up to 0.49 fs
+    float maxPosition = 0.0f;
+
+    float ic1eq = 0.0f, ic2eq = 0.0f;
+};
@@ -1,9 +1,113 @@
 #include "SynthOscillator.h"
+#include "FastSine.h"
+#include "PolyBlep.h"
+
+namespace
+{
+    // Phase runs in float within a chunk and is carried between chunks in
+    // double, so rounding can't build up over a long note
+    constexpr int chunkSize = 64;
+
+    using FastSine::wrap;
+    using PolyBlep::residual;
+
+    struct SineShape
+    {
+        static float sample (float t, float, float) noexcept
+        {
+            return FastSine::sin2pi (t);
+        }
+    };
+
+    struct TriangleShape
+    {
+        static float sample (float t, float, float) noexcept
+        {
+            return 2.0f * std::abs (2.0f * t - 1.0f) - 1.0f;
+        }
+    };
+
+    struct SawShape
+    {
+        static float sample (float t, float invDt, float) noexcept
+        {
+            return 2.0f * t - 1.0f - residual (t, invDt);
+        }
+    };
+
+    struct SquareShape
+    {
+        // The naive pulse is the difference of two saws, pw apart: +1 below
+        // the pulse width, -1 above, with no compare
+        static float sample (float t, float invDt, float pw) noexcept
+        {
+            auto shifted = wrap (t + 1.0f - pw);
+            return 2.0f * (shifted - t) + (2.0f * pw - 1.0f)
+                   + residual (t, invDt) - residual (shifted, invDt);
+        }
+    };
+
+    // One specialised, branch-free loop per waveform
+    template <typename Shape>
+    void renderShape (float* output, int numSamples, double& phase, double increment, float pulseWidth)
+    {
+        auto dt = (float) increment;
+        auto invDt = 1.0f / dt;
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            auto num = juce::jmin (chunkSize, numSamples - start);
+            auto base = (float) phase;
+            auto* out = output + start;
+
+            for (int i = 0; i < num; ++i)
+                out[i] = Shape::sample (wrap (base + (float) i * dt), invDt, pulseWidth);
+
+            phase += increment * num;
+            phase -= std::floor (phase);
+        }
+    }
+
+    // Two-operator phase modulation, chunked like renderShape. The bias keeps
+    // the modulated carrier phase non-negative for FastSine: an index of 16
+    // radians swings it by at most 2.55 cycles.
+    template <bool useEnvelope>
+    void renderFM (float* output, int numSamples, double& carrierPhase, double& modulatorPhase,
+                   double carrierIncrement, double modulatorIncrement, float index, const float* envelope)
+    {
+        constexpr float phaseBias = 4.0f;
+        auto depth = index / juce::MathConstants<float>::twoPi;
+        auto dc = (float) carrierIncrement;
+        auto dm = (float) modulatorIncrement;
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            auto num = juce::jmin (chunkSize, numSamples - start);
+            auto carrierBase = (float) carrierPhase + phaseBias;
+            auto modulatorBase = (float) modulatorPhase;
+            auto* out = output + start;
+
+            for (int i = 0; i < num; ++i)
+            {
+                auto amount = useEnvelope ? depth * envelope[start + i] : depth;
+                auto modulator = FastSine::sin2pi (modulatorBase + (float) i * dm);
+                out[i] = FastSine::sin2pi (carrierBase + (float) i * dc + amount * modulator);
+            }
+
+            carrierPhase += carrierIncrement * num;
+            carrierPhase -= std::floor (carrierPhase);
+            modulatorPhase += modulatorIncrement * num;
+            modulatorPhase -= std::floor (modulatorPhase);
+        }
+    }
+}
 
 void SynthOscillator::prepare (double sampleRate)
 {
     currentSampleRate = sampleRate;
     phase = 0.0;
+    modulatorPhase = 0.0;
+    tablePhase = 0;
     playing = false;
 }
 
@@ -12,7 +116,10 @@ void SynthOscillator::trigger (float velocity, float frequency)
     currentVelocity = velocity;
     double tunedFreq = frequency * std::pow (2.0, tune / 12.0);
     phaseIncrement = tunedFreq / currentSampleRate;
+    tableIncrement = Wavetable::phaseIncrement (phaseIncrement);
     phase = 0.0;
+    modulatorPhase = 0.0;
+    tablePhase = 0;
     playing = true;
 }
 
@@ -21,22 +128,23 @@ void SynthOscillator::stop()
     playing = false;
 }
 
-float SynthOscillator::polyBLEP (double t, double dt) const
+bool SynthOscillator::loadUserTable (const juce::File& file, juce::AudioFormatManager& formatManager)
 {
-    if (t < dt)
-    {
-        t /= dt;
-        return (float) (t + t - t * t - 1.0);
-    }
-    if (t > 1.0 - dt)
-    {
-        t = (t - 1.0) / dt;
-        return (float) (t * t + t + t + 1.0);
-    }
-    return 0.0f;
+    auto table = Wavetable::fromFile (file, formatManager);
+    if (table == nullptr)
+        return false;
+
+    userTable.publish (std::move (table));
+    return true;
+}
+
+juce::File SynthOscillator::getUserTableFile() const
+{
+    auto table = userTable.get();
+    return table != nullptr ? table->getFile() : juce::File();
 }
 
-void SynthOscillator::processBlock (float* output, int numSamples)
+void SynthOscillator::processBlock (float* output, int numSamples, const float* fmEnvelope)
 {
     if (! playing)
     {
@@ -44,47 +152,84 @@ void SynthOscillator::processBlock (float* output, int numSamples)
         return;
     }
 
-    double dt = phaseIncrement;
-
-    for (int i = 0; i < numSamples; ++i)
+    if (mode == Mode::FM)
     {
-        float sample = 0.0f;
+        auto modulatorIncrement = juce::jmin (phaseIncrement * (double) fmRatio, 0.5);
+        auto index = juce::jlimit (0.0f, 16.0f, fmIndex);
 
+        if (fmEnvelope != nullptr)
+            renderFM<true> (output, numSamples, phase, modulatorPhase, phaseIncrement, modulatorIncrement, index, fmEnvelope);
+        else
+            renderFM<false> (output, numSamples, phase, modulatorPhase, phaseIncrement, modulatorIncrement, index, nullptr);
+    }
+    else if (waveform == Waveform::User)
+    {
+        if (blockUserTable == nullptr)
+            juce::FloatVectorOperations::clear (output, numSamples);
+        else
+            renderWavetable (output, numSamples, blockUserTable);
+    }
+    else if (mode == Mode::Analog || waveform == Waveform::Sine)
+    {
+        // A sine can't alias, and the polynomial is cheaper than a table
+        renderAnalog (output, numSamples);
+    }
+    else
+    {
         switch (waveform)
         {
-            case Waveform::Sine:
-                sample = (float) std::sin (phase * juce::MathConstants<double>::twoPi);
-                break;
+            case Waveform::Sine:     break;
+            case Waveform::Triangle: renderWavetable (output, numSamples, bank->triangle.get()); break;
+            case Waveform::Saw:      renderWavetable (output, numSamples, bank->saw.get()); break;
+            case Waveform::Square:   renderPulseWavetable (output, numSamples); break;
+            case Waveform::User:     break;
+        }
+    }
 
-            case Waveform::Triangle:
-            {
-                sample = (float) (2.0 * std::abs (2.0 * phase - 1.0) - 1.0);
-                break;
-            }
+    juce::FloatVectorOperations::multiply (output, level * currentVelocity, numSamples);
+}
 
-            case Waveform::Saw:
-            {
-                sample = (float) (2.0 * phase - 1.0);
-                sample -= polyBLEP (phase, dt);
-                break;
-            }
+void SynthOscillator::renderWavetable (float* output, int numSamples, const Wavetable* table)
+{
+    // The pitch is fixed for the note, so the mip level is too
+    auto* samples = table->getLevel (Wavetable::levelForIncrement (tableIncrement));
+    auto p = tablePhase;
 
-            case Waveform::Square:
-            {
-                sample = (phase < (double) pulseWidth) ? 1.0f : -1.0f;
-                sample += polyBLEP (phase, dt);
-                double shiftedPhase = phase + (1.0 - (double) pulseWidth);
-                if (shiftedPhase >= 1.0)
-                    shiftedPhase -= 1.0;
-                sample -= polyBLEP (shiftedPhase, dt);
-                break;
-            }
-        }
+    for (int i = 0; i < numSamples; ++i)
+    {
+        output[i] = Wavetable::lookup (samples, p);
+        p += tableIncrement;
+    }
 
-        output[i] = sample * level * currentVelocity;
+    tablePhase = p;
+}
 
-        phase += dt;
-        if (phase >= 1.0)
-            phase -= 1.0;
+void SynthOscillator::renderPulseWavetable (float* output, int numSamples)
+{
+    // saw (p - pw) - saw (p) is +1 below the pulse width and -1 above, less
+    // the pulse's DC offset
+    auto* samples = bank->saw->getLevel (Wavetable::levelForIncrement (tableIncrement));
+    auto offset = (juce::uint32) (juce::int64) ((double) pulseWidth * 4294967296.0);
+    auto dc = 2.0f * pulseWidth - 1.0f;
+    auto p = tablePhase;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        output[i] = Wavetable::lookup (samples, p - offset) - Wavetable::lookup (samples, p) + dc;
+        p += tableIncrement;
+    }
+
+    tablePhase = p;
+}
+
+void SynthOscillator::renderAnalog (float* output, int numSamples)
+{
+    switch (waveform)
+    {
+        case Waveform::Sine:     renderShape<SineShape> (output, numSamples, phase, phaseIncrement, pulseWidth); break;
+        case Waveform::Triangle: renderShape<TriangleShape> (output, numSamples, phase, phaseIncrement, pulseWidth); break;
+        case Waveform::Saw:      renderShape<SawShape> (output, numSamples, phase, phaseIncrement, pulseWidth); break;
+        case Waveform::Square:   renderShape<SquareShape> (output, numSamples, phase, phaseIncrement, pulseWidth); break;
+        case Waveform::User:     break;
     }
 }
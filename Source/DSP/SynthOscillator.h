@@ -1,28 +1,61 @@
 #pragma once
 #include <juce_audio_basics/juce_audio_basics.h>
+#include "Wavetable.h"
+#include "../Utility/RcuHandle.h"
 
 class SynthOscillator
 {
 public:
-    enum class Waveform { Sine, Triangle, Saw, Square };
+    enum class Waveform { Sine, Triangle, Saw, Square, User };
+
+    // Analog computes the shapes directly (polyBLEP edges); Wavetable reads
+    // the shared band-limited tables. User always plays from its table.
+    // FM is a sine carrier phase-modulated by a sine at fmRatio times its
+    // frequency, ignoring the waveform.
+    enum class Mode { Analog, Wavetable, FM };
 
     void prepare (double sampleRate);
     void trigger (float velocity, float frequency);
     void stop();
-    void processBlock (float* output, int numSamples);
+
+    // Bracket each audio block; the user table is read in between
+    void beginBlock() noexcept { blockUserTable = userTable.beginRead(); }
+    void endBlock() noexcept { blockUserTable = nullptr; userTable.endRead(); }
+    // Plays another user table (or none) for the rest of this block
+    void overrideBlockUserTable (const Wavetable* table) noexcept { blockUserTable = table; }
+    // fmEnvelope, if given, scales the FM index per sample
+    void processBlock (float* output, int numSamples, const float* fmEnvelope = nullptr);
+
+    // Imports a single-cycle file for the User waveform (message thread)
+    bool loadUserTable (const juce::File& file, juce::AudioFormatManager& formatManager);
+    juce::File getUserTableFile() const;
+    // Publishes a ready-made user table, or clears it (message thread)
+    void setUserTable (std::shared_ptr<const Wavetable> table) { userTable.publish (std::move (table)); }
 
     Waveform waveform = Waveform::Sine;
+    Mode mode = Mode::Analog;
     float tune = 0.0f;       // semitones
     float pulseWidth = 0.5f;
     float level = 1.0f;
+    float fmRatio = 2.0f;    // modulator : carrier frequency
+    float fmIndex = 2.0f;    // peak phase deviation, radians (at most 16)
 
     bool isPlaying() const { return playing; }
 
 private:
-    float polyBLEP (double t, double dt) const;
+    void renderAnalog (float* output, int numSamples);
+    void renderWavetable (float* output, int numSamples, const Wavetable* table);
+    void renderPulseWavetable (float* output, int numSamples);
+
+    juce::SharedResourcePointer<WavetableBank> bank;
+    RcuHandle<Wavetable> userTable;
+    const Wavetable* blockUserTable = nullptr;
 
     double phase = 0.0;
     double phaseIncrement = 0.0;
+    double modulatorPhase = 0.0;
+    juce::uint32 tablePhase = 0;
+    juce::uint32 tableIncrement = 0;
     double currentSampleRate = 44100.0;
     float currentVelocity = 0.0f;
     bool playing = false;
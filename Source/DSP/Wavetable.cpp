@@ -0,0 +1,109 @@
+#include "Wavetable.h"
+#include <complex>
+
+std::shared_ptr<const Wavetable> Wavetable::fromHarmonics (const std::vector<float>& sines,
+                                                          const std::vector<float>& cosines)
+{
+    return build (sines, cosines);
+}
+
+std::shared_ptr<Wavetable> Wavetable::build (const std::vector<float>& sines, const std::vector<float>& cosines)
+{
+    constexpr auto mask = (size_t) tableSize - 1;
+
+    // sin (2 pi n i / N) is sineTable[(n * i) mod N]
+    std::vector<float> sineTable ((size_t) tableSize);
+    for (size_t i = 0; i < sineTable.size(); ++i)
+        sineTable[i] = (float) std::sin (juce::MathConstants<double>::twoPi * (double) i / (double) tableSize);
+
+    auto table = std::shared_ptr<Wavetable> (new Wavetable());
+    table->data.resize ((size_t) numLevels * (tableSize + 1), 0.0f);
+
+    auto numHarmonics = juce::jmin ((int) juce::jmax (sines.size(), cosines.size()), maxHarmonics);
+
+    for (int level = 0; level < numLevels; ++level)
+    {
+        auto* dest = table->data.data() + (size_t) level * (tableSize + 1);
+        auto levelHarmonics = juce::jmin (numHarmonics, maxHarmonics >> level);
+
+        for (int n = 1; n <= levelHarmonics; ++n)
+        {
+            auto s = (size_t) n <= sines.size() ? sines[(size_t) n - 1] : 0.0f;
+            auto c = (size_t) n <= cosines.size() ? cosines[(size_t) n - 1] : 0.0f;
+
+            for (size_t i = 0; i < (size_t) tableSize; ++i)
+            {
+                auto k = ((size_t) n * i) & mask;
+                dest[i] += s * sineTable[k] + c * sineTable[(k + (size_t) tableSize / 4) & mask];
+            }
+        }
+
+        dest[tableSize] = dest[0];
+    }
+
+    return table;
+}
+
+std::shared_ptr<const Wavetable> Wavetable::fromFile (const juce::File& file,
+                                                     juce::AudioFormatManager& formatManager)
+{
+    auto reader = std::unique_ptr<juce::AudioFormatReader> (formatManager.createReaderFor (file));
+    if (reader == nullptr || reader->lengthInSamples < 2 || reader->lengthInSamples > maxImportFrames)
+        return nullptr;
+
+    auto length = (int) reader->lengthInSamples;
+    juce::AudioBuffer<float> cycle (1, length);
+    reader->read (&cycle, 0, length, 0, true, false);
+
+    // Fourier series of the cycle; the DC term is dropped
+    auto* x = cycle.getReadPointer (0);
+    auto numHarmonics = juce::jmin (maxHarmonics, length / 2);
+    std::vector<float> sines ((size_t) numHarmonics), cosines ((size_t) numHarmonics);
+
+    for (int n = 1; n <= numHarmonics; ++n)
+    {
+        auto step = std::polar (1.0, juce::MathConstants<double>::twoPi * n / length);
+        std::complex<double> w (1.0, 0.0), sum (0.0, 0.0);
+
+        for (int i = 0; i < length; ++i)
+        {
+            sum += (double) x[i] * w;
+            w *= step;
+        }
+
+        cosines[(size_t) n - 1] = (float) (2.0 * sum.real() / length);
+        sines[(size_t) n - 1]   = (float) (2.0 * sum.imag() / length);
+    }
+
+    auto table = build (sines, cosines);
+
+    // Scale every level by the same amount, so the timbre doesn't get
+    // louder or quieter across octaves
+    auto peak = juce::FloatVectorOperations::findMaximum (table->data.data(), tableSize + 1);
+    peak = juce::jmax (peak, -juce::FloatVectorOperations::findMinimum (table->data.data(), tableSize + 1));
+    if (peak <= 1.0e-6f)
+        return nullptr;
+
+    juce::FloatVectorOperations::multiply (table->data.data(), 1.0f / peak, (int) table->data.size());
+    table->file = file;
+    return table;
+}
+
+WavetableBank::WavetableBank()
+{
+    // Series of the naive shapes in SynthOscillator, so both modes line up
+    // in phase and level
+    std::vector<float> sawSines ((size_t) Wavetable::maxHarmonics);
+    std::vector<float> triangleCosines ((size_t) Wavetable::maxHarmonics);
+    const auto pi = juce::MathConstants<float>::pi;
+
+    for (int n = 1; n <= Wavetable::maxHarmonics; ++n)
+    {
+        sawSines[(size_t) n - 1] = -2.0f / (pi * (float) n);
+        if (n % 2 == 1)
+            triangleCosines[(size_t) n - 1] = 8.0f / (pi * pi * (float) (n * n));
+    }
+
+    triangle = Wavetable::fromHarmonics ({}, triangleCosines);
+    saw = Wavetable::fromHarmonics (sawSines, {});
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+
+// One period of a waveform, stored as a stack of band-limited copies: level
+// n holds at most 512 >> n harmonics, so every octave of pitch has a table
+// that can't alias. Immutable once built; shared between oscillators.
+class Wavetable
+{
+public:
+    static constexpr int tableBits = 11;
+    static constexpr int tableSize = 1 << tableBits;
+    static constexpr int numLevels = 10;
+    static constexpr int maxHarmonics = 512;
+    static constexpr int maxImportFrames = 16384;
+
+    // Builds the mipmaps from a harmonic series: sines[n - 1] and cosines[n - 1]
+    // are the amplitudes of harmonic n (either may be shorter than the other)
+    static std::shared_ptr<const Wavetable> fromHarmonics (const std::vector<float>& sines,
+                                                           const std::vector<float>& cosines);
+
+    // Reads a single-cycle file: the whole of the first channel is one period.
+    // The result is DC-free and normalised to a peak of 1. Returns nullptr for
+    // unreadable files or ones too long to be a single cycle.
+    static std::shared_ptr<const Wavetable> fromFile (const juce::File& file,
+                                                      juce::AudioFormatManager& formatManager);
+
+    // Phase is a 32-bit fraction of a period, so it wraps for free
+    static juce::uint32 phaseIncrement (double cyclesPerSample) noexcept
+    {
+        return (juce::uint32) (juce::int64) (juce::jlimit (0.0, 0.5, cyclesPerSample) * 4294967296.0);
+    }
+
+    // Smallest level whose top harmonic stays below Nyquist at this increment
+    static int levelForIncrement (juce::uint32 increment) noexcept
+    {
+        int level = 0;
+        while (level < numLevels - 1 && (juce::uint64) increment * (juce::uint64) (maxHarmonics >> level) > 0x80000000ull)
+            ++level;
+        return level;
+    }
+
+    // tableSize + 1 samples; the last repeats the first for interpolation
+    const float* getLevel (int level) const noexcept { return data.data() + (size_t) level * (tableSize + 1); }
+
+    // Linear interpolation at a 32-bit phase
+    static float lookup (const float* table, juce::uint32 phase) noexcept
+    {
+        constexpr int fractionBits = 32 - tableBits;
+        auto index = phase >> fractionBits;
+        auto frac = (float) (phase & ((1u << fractionBits) - 1)) * (1.0f / (float) (1u << fractionBits));
+        return table[index] + frac * (table[index + 1] - table[index]);
+    }
+
+    const juce::File& getFile() const noexcept { return file; }
+
+private:
+    Wavetable() = default;
+
+    static std::shared_ptr<Wavetable> build (const std::vector<float>& sines, const std::vector<float>& cosines);
+
+    std::vector<float> data;
+    juce::File file;
+};
+
+// The stock shapes, built once per process. A sine is computed directly
+// (FastSine), and a band-limited pulse is the difference of two saws, so
+// neither needs a table of its own.
+struct WavetableBank
+{
+    WavetableBank();
+
+    std::shared_ptr<const Wavetable> triangle, saw;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+// White noise from eight independent xorshift32 generators, one per lane,
+// so a block is filled eight samples at a time with shifts, xors and an
+// int-to-float conversion that all vectorise. Output is uniform in [-1, 1).
+// Lanes left over when a fill ends mid-step are kept and come out first in
+// the next fill, so the sequence doesn't depend on how it's split into
+// blocks.
+class XorshiftNoise
+{
+public:
+    static constexpr int lanes = 8;
+
+    XorshiftNoise() { seed (juce::Random::getSystemRandom().nextInt()); }
+
+    // Same seed, same sequence
+    void seed (juce::uint32 value) noexcept
+    {
+        // splitmix32 spreads one seed over the lanes; xorshift needs non-zero state
+        for (size_t l = 0; l < state.size(); ++l)
+        {
+            auto z = value + 0x9e3779b9u * (juce::uint32) (l + 1);
+            z = (z ^ (z >> 16)) * 0x85ebca6bu;
+            z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+            z ^= z >> 16;
+            state[l] = z != 0 ? z : 0x6d2b79f5u;
+        }
+
+        numCarried = 0;
+    }
+
+    void fill (float* output, int numSamples) noexcept
+    {
+        int i = juce::jmin (numCarried, numSamples);
+        std::copy (carry.end() - numCarried, carry.end() - numCarried + i, output);
+        numCarried -= i;
+
+        auto s = state;
+
+        for (; i + lanes <= numSamples; i += lanes)
+            next (s, output + i);
+
+        if (i < numSamples)
+        {
+            next (s, carry.data());
+            std::copy (carry.begin(), carry.begin() + (numSamples - i), output + i);
+            numCarried = lanes - (numSamples - i);
+        }
+
+        state = s;
+    }
+
+private:
+    static void next (std::array<juce::uint32, lanes>& s, float* output) noexcept
+    {
+        for (size_t l = 0; l < (size_t) lanes; ++l)
+        {
+            auto x = s[l];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            s[l] = x;
+            output[l] = (float) (juce::int32) x * (1.0f / 2147483648.0f);
+        }
+    }
+
+    std::array<juce::uint32, lanes> state {};
+    std::array<float, lanes> carry {};   // the last numCarried are still unused
+    int numCarried = 0;
+};
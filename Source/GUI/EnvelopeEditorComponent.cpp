@@ -1,4 +1,5 @@
 #include "EnvelopeEditorComponent.h"
+#include "../DSP/Envelope.h"
 
 EnvelopeEditorComponent::EnvelopeEditorComponent (juce::Colour accentColour)
     : accent (accentColour)
@@ -7,45 +8,55 @@ EnvelopeEditorComponent::EnvelopeEditorComponent (juce::Colour accentColour)
 
 EnvelopeEditorComponent::~EnvelopeEditorComponent()
 {
-    if (apvtsPtr != nullptr)
-    {
-        if (attackID.isNotEmpty()) apvtsPtr->removeParameterListener (attackID, this);
-        if (decayID.isNotEmpty()) apvtsPtr->removeParameterListener (decayID, this);
-        if (sustainID.isNotEmpty()) apvtsPtr->removeParameterListener (sustainID, this);
-        if (releaseID.isNotEmpty()) apvtsPtr->removeParameterListener (releaseID, this);
-    }
+    removeListeners();
+}
+
+void EnvelopeEditorComponent::removeListeners()
+{
+    if (apvtsPtr == nullptr)
+        return;
+
+    for (auto* id : { &attackID, &decayID, &sustainID, &releaseID, &attackCurveID, &decayCurveID, &releaseCurveID })
+        if (id->isNotEmpty())
+            apvtsPtr->removeParameterListener (*id, this);
 }
 
 void EnvelopeEditorComponent::connectToParameters (juce::AudioProcessorValueTreeState& apvts,
                                                      const juce::String& aID,
                                                      const juce::String& dID,
                                                      const juce::String& sID,
-                                                     const juce::String& rID)
+                                                     const juce::String& rID,
+                                                     const juce::String& acID,
+                                                     const juce::String& dcID,
+                                                     const juce::String& rcID)
 {
     // Remove old listeners if reconnecting
-    if (apvtsPtr != nullptr)
-    {
-        if (attackID.isNotEmpty()) apvtsPtr->removeParameterListener (attackID, this);
-        if (decayID.isNotEmpty()) apvtsPtr->removeParameterListener (decayID, this);
-        if (sustainID.isNotEmpty()) apvtsPtr->removeParameterListener (sustainID, this);
-        if (releaseID.isNotEmpty()) apvtsPtr->removeParameterListener (releaseID, this);
-    }
+    removeListeners();
 
     apvtsPtr = &apvts;
     attackID = aID;
     decayID = dID;
     sustainID = sID;
     releaseID = rID;
+    attackCurveID = acID;
+    decayCurveID = dcID;
+    releaseCurveID = rcID;
 
     attackParam = apvts.getParameter (aID);
     decayParam = apvts.getParameter (dID);
     sustainParam = apvts.getParameter (sID);
     releaseParam = apvts.getParameter (rID);
+    attackCurveParam = apvts.getParameter (acID);
+    decayCurveParam = apvts.getParameter (dcID);
+    releaseCurveParam = apvts.getParameter (rcID);
 
     apvts.addParameterListener (aID, this);
     apvts.addParameterListener (dID, this);
     apvts.addParameterListener (sID, this);
     apvts.addParameterListener (rID, this);
+    apvts.addParameterListener (acID, this);
+    apvts.addParameterListener (dcID, this);
+    apvts.addParameterListener (rcID, this);
 
     repaint();
 }
@@ -100,6 +111,21 @@ int EnvelopeEditorComponent::findDragPoint (juce::Point<float> pos) const
     return -1;
 }
 
+float EnvelopeEditorComponent::getCurve (const juce::RangedAudioParameter* param) const
+{
+    return param != nullptr ? param->convertFrom0to1 (param->getValue()) : 0.0f;
+}
+
+juce::RangedAudioParameter* EnvelopeEditorComponent::findCurveParam (float x) const
+{
+    auto pts = calculatePoints();
+
+    if (x < pts[1].x) return attackCurveParam;
+    if (x < pts[2].x) return decayCurveParam;
+    if (x >= pts[3].x) return releaseCurveParam;
+    return nullptr;
+}
+
 void EnvelopeEditorComponent::paint (juce::Graphics& g)
 {
     float w = (float) getWidth();
@@ -114,11 +140,27 @@ void EnvelopeEditorComponent::paint (juce::Graphics& g)
     auto pts = calculatePoints();
     float ih = h - padding * 2 - 12;
 
+    // Outline, with each timed segment bent by its curve
+    const float curves[] = { getCurve (attackCurveParam), getCurve (decayCurveParam), 0.0f, getCurve (releaseCurveParam) };
+    juce::Path strokePath;
+    strokePath.startNewSubPath (pts[0].x, pts[0].y);
+
+    for (size_t seg = 0; seg < 4; ++seg)
+    {
+        auto from = pts[seg];
+        auto to = pts[seg + 1];
+        const int steps = curves[seg] != 0.0f ? 24 : 1;
+
+        for (int i = 1; i <= steps; ++i)
+        {
+            auto x = (float) i / (float) steps;
+            strokePath.lineTo (from.x + (to.x - from.x) * x,
+                               from.y + (to.y - from.y) * Envelope::segmentShape (x, curves[seg]));
+        }
+    }
+
     // Fill under curve
-    juce::Path fillPath;
-    fillPath.startNewSubPath (pts[0].x, pts[0].y);
-    for (int i = 1; i < 5; ++i)
-        fillPath.lineTo (pts[(size_t) i].x, pts[(size_t) i].y);
+    juce::Path fillPath (strokePath);
     fillPath.lineTo (pts[4].x, padding + ih);
     fillPath.lineTo (padding, padding + ih);
     fillPath.closeSubPath();
@@ -128,11 +170,6 @@ void EnvelopeEditorComponent::paint (juce::Graphics& g)
     g.fillPath (fillPath);
 
     // Stroke
-    juce::Path strokePath;
-    strokePath.startNewSubPath (pts[0].x, pts[0].y);
-    for (int i = 1; i < 5; ++i)
-        strokePath.lineTo (pts[(size_t) i].x, pts[(size_t) i].y);
-
     g.setColour (accent);
     g.strokePath (strokePath, juce::PathStrokeType (1.5f, juce::PathStrokeType::curved,
                                                      juce::PathStrokeType::rounded));
@@ -230,3 +267,15 @@ void EnvelopeEditorComponent::mouseUp (const juce::MouseEvent&)
     draggingPoint = -1;
     repaint();
 }
+
+void EnvelopeEditorComponent::mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    auto* param = findCurveParam (e.position.x);
+    if (param == nullptr)
+        return;
+
+    auto curve = std::clamp (getCurve (param) + wheel.deltaY, -1.0f, 1.0f);
+    param->beginChangeGesture();
+    param->setValueNotifyingHost (param->convertTo0to1 (curve));
+    param->endChangeGesture();
+}
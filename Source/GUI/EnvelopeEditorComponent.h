@@ -13,12 +13,17 @@ public:
                               const juce::String& attackID,
                               const juce::String& decayID,
                               const juce::String& sustainID,
-                              const juce::String& releaseID);
+                              const juce::String& releaseID,
+                              const juce::String& attackCurveID,
+                              const juce::String& decayCurveID,
+                              const juce::String& releaseCurveID);
 
     void paint (juce::Graphics& g) override;
     void mouseDown (const juce::MouseEvent& e) override;
     void mouseDrag (const juce::MouseEvent& e) override;
     void mouseUp (const juce::MouseEvent& e) override;
+    // Bends the curve of the segment under the mouse
+    void mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
 
     void parameterChanged (const juce::String& parameterID, float newValue) override;
 
@@ -26,6 +31,9 @@ private:
     struct EnvPoint { float x, y; };
     std::array<EnvPoint, 5> calculatePoints() const;
     int findDragPoint (juce::Point<float> pos) const;
+    juce::RangedAudioParameter* findCurveParam (float x) const;
+    float getCurve (const juce::RangedAudioParameter* param) const;
+    void removeListeners();
 
     juce::Colour accent;
     juce::AudioProcessorValueTreeState* apvtsPtr = nullptr;
@@ -33,8 +41,12 @@ private:
     juce::RangedAudioParameter* decayParam = nullptr;
     juce::RangedAudioParameter* sustainParam = nullptr;
     juce::RangedAudioParameter* releaseParam = nullptr;
+    juce::RangedAudioParameter* attackCurveParam = nullptr;
+    juce::RangedAudioParameter* decayCurveParam = nullptr;
+    juce::RangedAudioParameter* releaseCurveParam = nullptr;
 
     juce::String attackID, decayID, sustainID, releaseID;
+    juce::String attackCurveID, decayCurveID, releaseCurveID;
 
     int draggingPoint = -1;
     static constexpr float padding = 8.0f;
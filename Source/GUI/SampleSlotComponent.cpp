@@ -46,30 +46,44 @@ void SampleSlotComponent::mouseDown (const juce::MouseEvent&)
         juce::File::getSpecialLocation (juce::File::userHomeDirectory),
         "*.wav;*.aif;*.aiff;*.flac;*.mp3;*.ogg");
 
-    chooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+    chooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles
+                              | juce::FileBrowserComponent::canSelectMultipleItems,
         [this, chooser] (const juce::FileChooser& fc)
         {
-            auto result = fc.getResult();
-            if (result.existsAsFile())
-            {
-                sampleName = result.getFileName();
-                isLoaded = true;
-                repaint();
-
-                if (onSampleLoaded)
-                    onSampleLoaded (result);
-            }
+            filesChosen (fc.getResults());
         });
 }
 
+bool SampleSlotComponent::isAudioFile (const juce::File& file)
+{
+    auto ext = file.getFileExtension().toLowerCase();
+    return ext == ".wav" || ext == ".aif" || ext == ".aiff" || ext == ".flac" || ext == ".mp3" || ext == ".ogg";
+}
+
+void SampleSlotComponent::filesChosen (const juce::Array<juce::File>& files)
+{
+    juce::Array<juce::File> samples;
+    for (auto& file : files)
+        if (file.existsAsFile() && isAudioFile (file))
+            samples.add (file);
+
+    if (samples.isEmpty())
+        return;
+
+    sampleName = samples.size() == 1 ? samples[0].getFileName()
+                                     : samples[0].getFileName() + " (+" + juce::String (samples.size() - 1) + ")";
+    isLoaded = true;
+    repaint();
+
+    if (onSamplesLoaded)
+        onSamplesLoaded (samples);
+}
+
 bool SampleSlotComponent::isInterestedInFileDrag (const juce::StringArray& files)
 {
     for (auto& f : files)
-    {
-        auto ext = juce::File (f).getFileExtension().toLowerCase();
-        if (ext == ".wav" || ext == ".aif" || ext == ".aiff" || ext == ".flac" || ext == ".mp3" || ext == ".ogg")
+        if (isAudioFile (juce::File (f)))
             return true;
-    }
     return false;
 }
 
@@ -88,20 +102,13 @@ void SampleSlotComponent::fileDragExit (const juce::StringArray&)
 void SampleSlotComponent::filesDropped (const juce::StringArray& files, int, int)
 {
     isDragOver = false;
+    repaint();
 
-    if (! files.isEmpty())
-    {
-        juce::File file (files[0]);
-        if (file.existsAsFile())
-        {
-            sampleName = file.getFileName();
-            isLoaded = true;
-            repaint();
+    juce::Array<juce::File> dropped;
+    for (auto& f : files)
+        dropped.add (juce::File (f));
 
-            if (onSampleLoaded)
-                onSampleLoaded (file);
-        }
-    }
+    filesChosen (dropped);
 }
 
 void SampleSlotComponent::setSampleName (const juce::String& name)
@@ -18,9 +18,13 @@ public:
 
     void setSampleName (const juce::String& name);
 
-    std::function<void (const juce::File&)> onSampleLoaded;
+    // Several files load as velocity/round-robin zones
+    std::function<void (const juce::Array<juce::File>&)> onSamplesLoaded;
 
 private:
+    static bool isAudioFile (const juce::File& file);
+    void filesChosen (const juce::Array<juce::File>& files);
+
     juce::String labelText;
     juce::String sampleName;
     juce::Colour accent;
@@ -10,14 +10,24 @@ VoiceStripComponent::VoiceStripComponent (int partIdx, juce::Colour accentColour
       processor (proc),
       sample1Slot ("SAMPLE 1", accent),
       sample2Slot ("SAMPLE 2", accent),
+      s1TransientSelector ({ "Start", "T1", "T2", "T3", "T4", "T5", "T6", "T7", "T8" }, accent),
+      s2TransientSelector ({ "Start", "T1", "T2", "T3", "T4", "T5", "T6", "T7", "T8" }, accent),
       synthLevel ("Level", accent),
       synthTune ("Tune", accent, true),
       synthPW ("PW", accent),
-      waveformSelector ({ "Sine", "Tri", "Saw", "Sqr" }, accent),
+      synthRatio ("Ratio", accent),
+      synthIndex ("Index", accent),
+      waveformSelector ({ "Sine", "Tri", "Saw", "Sqr", "User" }, accent),
+      synthModeSelector ({ "Analog", "Table", "FM" }, accent),
+      fmEnvSelector ({ "No Env", "Env 1", "Env 2", "Env 3", "Env 4" }, accent),
       noiseLevel ("Level", accent),
       noiseFilter ("Filter", accent),
       noiseTone ("Tone", accent),
-      noiseTypeSelector ({ "White", "Pink", "Metal" }, accent),
+      noiseResonance ("Res", accent),
+      noiseEnvAmount ("Env", accent, true),
+      noiseTypeSelector ({ "White", "Pink", "Metal", "808" }, accent),
+      noiseFilterModeSelector ({ "1-Pole", "LP", "BP", "HP" }, accent),
+      noiseFilterEnvSelector ({ "No Env", "Env 1", "Env 2", "Env 3", "Env 4" }, accent),
       envelopeEditor (accent),
       envAssign (accent),
       atDampen ("Dampen", accent),
@@ -33,14 +43,28 @@ VoiceStripComponent::VoiceStripComponent (int partIdx, juce::Colour accentColour
     // Add all children
     addAndMakeVisible (sample1Slot);
     addAndMakeVisible (sample2Slot);
+    addAndMakeVisible (s1TrimButton);
+    addAndMakeVisible (s1GainButton);
+    addAndMakeVisible (s1TransientSelector);
+    addAndMakeVisible (s2TrimButton);
+    addAndMakeVisible (s2GainButton);
+    addAndMakeVisible (s2TransientSelector);
     addAndMakeVisible (synthLevel);
     addAndMakeVisible (synthTune);
     addAndMakeVisible (synthPW);
+    addAndMakeVisible (synthRatio);
+    addAndMakeVisible (synthIndex);
     addAndMakeVisible (waveformSelector);
+    addAndMakeVisible (synthModeSelector);
+    addAndMakeVisible (fmEnvSelector);
     addAndMakeVisible (noiseLevel);
     addAndMakeVisible (noiseFilter);
     addAndMakeVisible (noiseTone);
+    addAndMakeVisible (noiseResonance);
+    addAndMakeVisible (noiseEnvAmount);
     addAndMakeVisible (noiseTypeSelector);
+    addAndMakeVisible (noiseFilterModeSelector);
+    addAndMakeVisible (noiseFilterEnvSelector);
     addAndMakeVisible (envelopeEditor);
     addAndMakeVisible (envAssign);
     addAndMakeVisible (atDampen);
@@ -54,17 +78,49 @@ VoiceStripComponent::VoiceStripComponent (int partIdx, juce::Colour accentColour
     // --- Attach parameters ---
 
     // Sample slots
-    sample1Slot.onSampleLoaded = [this](const juce::File& file) {
-        processor.getEngine().getVoice (partIndex).getSample1().loadSample (file, processor.getFormatManager());
+    sample1Slot.onSamplesLoaded = [this](const juce::Array<juce::File>& files) {
+        processor.getEngine().getVoice (partIndex).getSample1().loadZones (files, processor.getFormatManager());
+        processor.prepareEmbeddedSamples();
     };
-    sample2Slot.onSampleLoaded = [this](const juce::File& file) {
-        processor.getEngine().getVoice (partIndex).getSample2().loadSample (file, processor.getFormatManager());
+    sample2Slot.onSamplesLoaded = [this](const juce::Array<juce::File>& files) {
+        processor.getEngine().getVoice (partIndex).getSample2().loadZones (files, processor.getFormatManager());
+        processor.prepareEmbeddedSamples();
     };
 
-    // Show existing sample names
-    auto& voice = processor.getEngine().getVoice (partIndex);
-    sample1Slot.setSampleName (voice.getSample1().getFileName());
-    sample2Slot.setSampleName (voice.getSample2().getFileName());
+    // Start point and gain options, from each sample's analysis
+    auto styleToggle = [this](juce::TextButton& button, const juce::String& tooltip)
+    {
+        button.setClickingTogglesState (true);
+        button.setColour (juce::TextButton::buttonColourId, Colours::strip);
+        button.setColour (juce::TextButton::buttonOnColourId, accent.withAlpha (0.2f));
+        button.setColour (juce::TextButton::textColourOffId, Colours::textMuted);
+        button.setColour (juce::TextButton::textColourOnId, accent);
+        button.setTooltip (tooltip);
+    };
+
+    for (auto* button : { &s1TrimButton, &s2TrimButton })
+        styleToggle (*button, "Skip leading silence; Start then covers the rest");
+    for (auto* button : { &s1GainButton, &s2GainButton })
+        styleToggle (*button, "Match each sample's loudness to a common level");
+
+    s1TrimAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (
+        apvts, pid (ParamIDs::S1_TRIM), s1TrimButton);
+    s1GainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (
+        apvts, pid (ParamIDs::S1_NORM), s1GainButton);
+    s2TrimAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (
+        apvts, pid (ParamIDs::S2_TRIM), s2TrimButton);
+    s2GainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (
+        apvts, pid (ParamIDs::S2_NORM), s2GainButton);
+
+    // Start at the sample start, or at one of its detected transients
+    s1TransientSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
+        apvts, pid (ParamIDs::S1_TRANS), s1TransientSelector.getComboBox()));
+    s2TransientSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
+        apvts, pid (ParamIDs::S2_TRANS), s2TransientSelector.getComboBox()));
+
+    // Show existing sample names, and keep them current as loads finish
+    updateSampleNames();
+    processor.sampleLoadBroadcaster.addChangeListener (this);
 
     // Synth knobs
     synthLevel.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
@@ -73,10 +129,24 @@ VoiceStripComponent::VoiceStripComponent (int partIdx, juce::Colour accentColour
         apvts, pid (ParamIDs::SYN_TUNE), synthTune.getSlider()));
     synthPW.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
         apvts, pid (ParamIDs::SYN_PW), synthPW.getSlider()));
+    synthRatio.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
+        apvts, pid (ParamIDs::SYN_RATIO), synthRatio.getSlider()));
+    synthIndex.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
+        apvts, pid (ParamIDs::SYN_INDEX), synthIndex.getSlider()));
 
     // Waveform selector
     waveformSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
         apvts, pid (ParamIDs::SYN_WAVE), waveformSelector.getComboBox()));
+    synthModeSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
+        apvts, pid (ParamIDs::SYN_MODE), synthModeSelector.getComboBox()));
+    fmEnvSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
+        apvts, pid (ParamIDs::SYN_FMENV), fmEnvSelector.getComboBox()));
+
+    // Right-click USER to import a single-cycle wavetable
+    waveformSelector.onItemMenu = [this](int index) {
+        if (index == (int) SynthOscillator::Waveform::User)
+            chooseUserWavetable();
+    };
 
     // Noise knobs
     noiseLevel.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
@@ -85,10 +155,18 @@ VoiceStripComponent::VoiceStripComponent (int partIdx, juce::Colour accentColour
         apvts, pid (ParamIDs::NSE_FILT), noiseFilter.getSlider()));
     noiseTone.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
         apvts, pid (ParamIDs::NSE_TONE), noiseTone.getSlider()));
+    noiseResonance.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
+        apvts, pid (ParamIDs::NSE_RES), noiseResonance.getSlider()));
+    noiseEnvAmount.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
+        apvts, pid (ParamIDs::NSE_FAMT), noiseEnvAmount.getSlider()));
 
     // Noise type selector
     noiseTypeSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
         apvts, pid (ParamIDs::NSE_TYPE), noiseTypeSelector.getComboBox()));
+    noiseFilterModeSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
+        apvts, pid (ParamIDs::NSE_FMODE), noiseFilterModeSelector.getComboBox()));
+    noiseFilterEnvSelector.setAttachment (std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
+        apvts, pid (ParamIDs::NSE_FENV), noiseFilterEnvSelector.getComboBox()));
 
     // Envelope editor (connect to env 1 by default)
     updateEnvelopeConnection();
@@ -133,11 +211,52 @@ void VoiceStripComponent::updateEnvelopeConnection()
         ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_A),
         ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_D),
         ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_S),
-        ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_R));
+        ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_R),
+        ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_AC),
+        ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_DC),
+        ParamIDs::envParam (partIndex, selectedEnvTab, ParamIDs::ENV_RC));
 
     envAssign.setSelectedEnvelope (selectedEnvTab);
 }
 
+VoiceStripComponent::~VoiceStripComponent()
+{
+    processor.sampleLoadBroadcaster.removeChangeListener (this);
+}
+
+void VoiceStripComponent::changeListenerCallback (juce::ChangeBroadcaster*)
+{
+    updateSampleNames();
+}
+
+void VoiceStripComponent::updateSampleNames()
+{
+    auto& voice = processor.getEngine().getVoice (partIndex);
+    sample1Slot.setSampleName (voice.getSample1().getFileName());
+    sample2Slot.setSampleName (voice.getSample2().getFileName());
+}
+
+void VoiceStripComponent::chooseUserWavetable()
+{
+    auto chooser = std::make_shared<juce::FileChooser> (
+        "Select a single-cycle waveform...",
+        juce::File::getSpecialLocation (juce::File::userHomeDirectory),
+        "*.wav;*.aif;*.aiff;*.flac");
+
+    chooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+        [this, chooser] (const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (! file.existsAsFile())
+                return;
+
+            auto& synth = processor.getEngine().getVoice (partIndex).getSynth();
+            if (synth.loadUserTable (file, processor.getFormatManager()))
+                waveformSelector.getComboBox().setSelectedItemIndex ((int) SynthOscillator::Waveform::User,
+                                                                     juce::sendNotificationSync);
+        });
+}
+
 void VoiceStripComponent::setEnvelopeTab (int index)
 {
     if (index == selectedEnvTab) return;
@@ -182,7 +301,7 @@ void VoiceStripComponent::paint (juce::Graphics& g)
     paintSectionLabel (inner.getY() + 28, "SOURCES");
 
     // Envelopes label
-    float envLabelY = noiseTypeSelector.getBottom() + 4.0f;
+    float envLabelY = noiseFilterEnvSelector.getBottom() + 4.0f;
     paintSectionLabel (envLabelY, "ENVELOPES");
 
     // Envelope tabs
@@ -238,39 +357,64 @@ void VoiceStripComponent::resized()
     // Sources section label
     bounds.removeFromTop (16);
 
-    // Sample slots
+    // Sample slots, each followed by its option row
+    auto layoutOptionRow = [&](juce::TextButton& trim, juce::TextButton& gain, WaveformSelector& transient)
+    {
+        auto row = bounds.removeFromTop (16);
+        trim.setBounds (row.removeFromLeft (36));
+        row.removeFromLeft (3);
+        gain.setBounds (row.removeFromLeft (36));
+        row.removeFromLeft (6);
+        transient.setBounds (row);
+        bounds.removeFromTop (4);
+    };
+
     sample1Slot.setBounds (bounds.removeFromTop (32));
     bounds.removeFromTop (4);
+    layoutOptionRow (s1TrimButton, s1GainButton, s1TransientSelector);
     sample2Slot.setBounds (bounds.removeFromTop (32));
     bounds.removeFromTop (4);
+    layoutOptionRow (s2TrimButton, s2GainButton, s2TransientSelector);
 
     // Synth OSC section
     {
-        auto synthArea = bounds.removeFromTop (80);
+        auto synthArea = bounds.removeFromTop (124);
         // Label + background drawn in paint
 
         auto knobRow = synthArea.removeFromTop (48);
-        int knobW = knobRow.getWidth() / 3;
+        int knobW = knobRow.getWidth() / 5;
         synthLevel.setBounds (knobRow.removeFromLeft (knobW));
         synthTune.setBounds (knobRow.removeFromLeft (knobW));
-        synthPW.setBounds (knobRow);
+        synthPW.setBounds (knobRow.removeFromLeft (knobW));
+        synthRatio.setBounds (knobRow.removeFromLeft (knobW));
+        synthIndex.setBounds (knobRow);
 
         synthArea.removeFromTop (4);
         waveformSelector.setBounds (synthArea.removeFromTop (18));
+        synthArea.removeFromTop (4);
+        synthModeSelector.setBounds (synthArea.removeFromTop (18));
+        synthArea.removeFromTop (4);
+        fmEnvSelector.setBounds (synthArea.removeFromTop (18));
     }
     bounds.removeFromTop (4);
 
     // Noise section
     {
-        auto noiseArea = bounds.removeFromTop (80);
+        auto noiseArea = bounds.removeFromTop (124);
         auto knobRow = noiseArea.removeFromTop (48);
-        int knobW = knobRow.getWidth() / 3;
+        int knobW = knobRow.getWidth() / 5;
         noiseLevel.setBounds (knobRow.removeFromLeft (knobW));
         noiseFilter.setBounds (knobRow.removeFromLeft (knobW));
-        noiseTone.setBounds (knobRow);
+        noiseTone.setBounds (knobRow.removeFromLeft (knobW));
+        noiseResonance.setBounds (knobRow.removeFromLeft (knobW));
+        noiseEnvAmount.setBounds (knobRow);
 
         noiseArea.removeFromTop (4);
         noiseTypeSelector.setBounds (noiseArea.removeFromTop (18));
+        noiseArea.removeFromTop (4);
+        noiseFilterModeSelector.setBounds (noiseArea.removeFromTop (18));
+        noiseArea.removeFromTop (4);
+        noiseFilterEnvSelector.setBounds (noiseArea.removeFromTop (18));
     }
     bounds.removeFromTop (4);
 
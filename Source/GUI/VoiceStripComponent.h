@@ -11,12 +11,14 @@
 
 class PulsePluginProcessor;
 
-class VoiceStripComponent : public juce::Component
+class VoiceStripComponent : public juce::Component,
+                            private juce::ChangeListener
 {
 public:
     VoiceStripComponent (int partIndex, juce::Colour accentColour,
                          juce::AudioProcessorValueTreeState& apvts,
                          PulsePluginProcessor& processor);
+    ~VoiceStripComponent() override;
 
     void paint (juce::Graphics& g) override;
     void resized() override;
@@ -31,16 +33,21 @@ private:
     juce::AudioProcessorValueTreeState& apvts;
     PulsePluginProcessor& processor;
 
-    // Sample slots
+    // Sample slots, each with a row for its start point and gain options
     SampleSlotComponent sample1Slot, sample2Slot;
+    juce::TextButton s1TrimButton { "TRIM" }, s1GainButton { "GAIN" };
+    juce::TextButton s2TrimButton { "TRIM" }, s2GainButton { "GAIN" };
+    WaveformSelector s1TransientSelector, s2TransientSelector;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> s1TrimAttachment, s1GainAttachment,
+                                                                          s2TrimAttachment, s2GainAttachment;
 
     // Synth section
-    KnobComponent synthLevel, synthTune, synthPW;
-    WaveformSelector waveformSelector;
+    KnobComponent synthLevel, synthTune, synthPW, synthRatio, synthIndex;
+    WaveformSelector waveformSelector, synthModeSelector, fmEnvSelector;
 
     // Noise section
-    KnobComponent noiseLevel, noiseFilter, noiseTone;
-    WaveformSelector noiseTypeSelector;
+    KnobComponent noiseLevel, noiseFilter, noiseTone, noiseResonance, noiseEnvAmount;
+    WaveformSelector noiseTypeSelector, noiseFilterModeSelector, noiseFilterEnvSelector;
 
     // Envelope section
     int selectedEnvTab = 0;
@@ -61,5 +68,11 @@ private:
     // Helper to connect the envelope editor to the currently selected envelope tab
     void updateEnvelopeConnection();
 
+    // Refreshes the slot names when background sample loads complete
+    void changeListenerCallback (juce::ChangeBroadcaster*) override;
+    void updateSampleNames();
+
+    void chooseUserWavetable();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceStripComponent)
 };
@@ -62,6 +62,12 @@ void WaveformSelector::mouseDown (const juce::MouseEvent& e)
     int clicked = (int) (e.position.x / itemWidth);
     clicked = juce::jlimit (0, numItems - 1, clicked);
 
+    if (e.mods.isPopupMenu() && onItemMenu != nullptr)
+    {
+        onItemMenu (clicked);
+        return;
+    }
+
     hiddenCombo.setSelectedItemIndex (clicked, juce::sendNotificationSync);
 }
 
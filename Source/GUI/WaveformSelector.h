@@ -15,6 +15,9 @@ public:
 
     void setAttachment (std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> att);
 
+    // Called instead of selecting when an item is right-clicked
+    std::function<void (int index)> onItemMenu;
+
     // Internal combo box for APVTS attachment
     juce::ComboBox& getComboBox() { return hiddenCombo; }
 
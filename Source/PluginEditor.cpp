@@ -5,6 +5,26 @@ PulsePluginEditor::PulsePluginEditor (PulsePluginProcessor& p)
 {
     addAndMakeVisible (header);
 
+    kitBox.setColour (juce::ComboBox::backgroundColourId, Colours::surfaceAlt);
+    kitBox.setColour (juce::ComboBox::outlineColourId, Colours::stripBorder);
+    kitBox.setColour (juce::ComboBox::textColourId, Colours::text);
+    kitBox.setColour (juce::ComboBox::arrowColourId, Colours::textMuted);
+    kitBox.setTextWhenNothingSelected ("NO KIT");
+    kitBox.setTooltip ("Kits switch at the next audio block; the one after is preloaded");
+    kitBox.onChange = [this]
+    {
+        auto index = kitBox.getSelectedItemIndex();
+        if (index >= 0 && index != processor.getPresetLibrary().getCurrentIndex())
+            processor.getPresetLibrary().select (index);
+    };
+    addAndMakeVisible (kitBox);
+
+    saveKitButton.setColour (juce::TextButton::buttonColourId, Colours::surfaceAlt);
+    saveKitButton.setColour (juce::TextButton::textColourOffId, Colours::textMuted);
+    saveKitButton.setTooltip ("Save the current state as a kit in the library");
+    saveKitButton.onClick = [this] { saveKit(); };
+    addAndMakeVisible (saveKitButton);
+
     for (int i = 0; i < Constants::NUM_PARTS; ++i)
     {
         auto* strip = new VoiceStripComponent (i, Colours::accent[i], processor.apvts, processor);
@@ -12,9 +32,47 @@ PulsePluginEditor::PulsePluginEditor (PulsePluginProcessor& p)
         voiceStrips.add (strip);
     }
 
-    setSize (960, 820);
+    interpolationBox.addItemList ({ "Linear", "Hermite", "Sinc" }, 1);
+    interpolationBox.setColour (juce::ComboBox::backgroundColourId, Colours::surfaceAlt);
+    interpolationBox.setColour (juce::ComboBox::outlineColourId, Colours::stripBorder);
+    interpolationBox.setColour (juce::ComboBox::textColourId, Colours::textDim);
+    interpolationBox.setColour (juce::ComboBox::arrowColourId, Colours::textMuted);
+    interpolationBox.setTooltip ("Sample interpolation (offline renders always use Sinc)");
+    addAndMakeVisible (interpolationBox);
+    interpolationAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment> (
+        processor.apvts, ParamIDs::INTERP, interpolationBox);
+
+    // Item order matches SamplePlayer::Storage
+    storageBox.addItemList ({ "Float", "Mapped", "Compact" }, 1);
+    storageBox.setColour (juce::ComboBox::backgroundColourId, Colours::surfaceAlt);
+    storageBox.setColour (juce::ComboBox::outlineColourId, Colours::stripBorder);
+    storageBox.setColour (juce::ComboBox::textColourId, Colours::textDim);
+    storageBox.setColour (juce::ComboBox::arrowColourId, Colours::textMuted);
+    storageBox.setTooltip ("Sample storage: 32-bit float, memory-mapped file, or int16/24-bit");
+    storageBox.setSelectedItemIndex ((int) processor.getSampleStorage(), juce::dontSendNotification);
+    storageBox.onChange = [this]
+    {
+        processor.setSampleStorage ((SamplePlayer::Storage) storageBox.getSelectedItemIndex());
+        timerCallback();
+    };
+    addAndMakeVisible (storageBox);
+
+    embedButton.setClickingTogglesState (true);
+    embedButton.setToggleState (processor.getEmbedSamples(), juce::dontSendNotification);
+    embedButton.setColour (juce::TextButton::buttonColourId, Colours::surfaceAlt);
+    embedButton.setColour (juce::TextButton::buttonOnColourId, Colours::textDim.withAlpha (0.2f));
+    embedButton.setColour (juce::TextButton::textColourOffId, Colours::textMuted);
+    embedButton.setColour (juce::TextButton::textColourOnId, Colours::text);
+    embedButton.setTooltip ("Save sample audio inside the project (files over 16 MB, or still being packed, are saved by path)");
+    embedButton.onClick = [this] { processor.setEmbedSamples (embedButton.getToggleState()); };
+    addAndMakeVisible (embedButton);
+
+    setSize (960, 860);
     setResizable (true, true);
     setResizeLimits (800, 700, 1600, 1200);
+
+    timerCallback();
+    startTimer (500);
 }
 
 PulsePluginEditor::~PulsePluginEditor() {}
@@ -33,16 +91,92 @@ void PulsePluginEditor::paint (juce::Graphics& g)
     auto monoFont = juce::Font::getDefaultMonospacedFontName();
     g.setColour (Colours::textMuted);
     g.setFont (juce::Font (juce::FontOptions (monoFont, 8.0f, juce::Font::plain)));
+    int footerY = (int) footerArea.getY();
+    int footerH = (int) footerArea.getHeight();
+    int memoryX = embedButton.getX() - 8 - 150;
+
     g.drawText ("MIDI: MULTITIMBRAL CH 1-4    AFTERTOUCH: CHANNEL PRESSURE    POLYPHONY: 4-VOICE",
-                footerArea.reduced (20, 0).toNearestInt(), juce::Justification::centredLeft);
+                20, footerY, memoryX - 28, footerH, juce::Justification::centredLeft);
     g.drawText ("v0.1.0", footerArea.reduced (20, 0).toNearestInt(), juce::Justification::centredRight);
+    g.drawText ("INTERP", interpolationBox.getX() - 44, footerY, 40, footerH, juce::Justification::centredRight);
+    g.drawText ("STORAGE", storageBox.getX() - 52, footerY, 48, footerH, juce::Justification::centredRight);
+    g.drawText (memoryText, memoryX, footerY, 146, footerH, juce::Justification::centredRight);
+}
+
+void PulsePluginEditor::refreshKitList()
+{
+    auto& library = processor.getPresetLibrary();
+
+    juce::StringArray names;
+    for (int i = 0; i < library.getNumPresets(); ++i)
+        names.add (library.getPresetName (i) + (library.isUnreadable (i) ? " (unreadable)" : ""));
+
+    if (names != kitNames)
+    {
+        kitNames = names;
+        kitBox.clear (juce::dontSendNotification);
+        kitBox.addItemList (kitNames, 1);
+    }
+
+    if (kitBox.getSelectedItemIndex() != library.getCurrentIndex())
+        kitBox.setSelectedItemIndex (library.getCurrentIndex(), juce::dontSendNotification);
+}
+
+void PulsePluginEditor::saveKit()
+{
+    auto& library = processor.getPresetLibrary();
+    auto chooser = std::make_shared<juce::FileChooser> (
+        "Save kit...",
+        library.getFolder().getChildFile ("New Kit").withFileExtension (PresetLibrary::fileExtension),
+        juce::String ("*") + PresetLibrary::fileExtension);
+
+    chooser->launchAsync (juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles,
+        [this, chooser] (const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (file == juce::File())
+                return;
+
+            processor.saveKit (file);
+            refreshKitList();
+        });
+}
+
+void PulsePluginEditor::timerCallback()
+{
+    refreshKitList();
+
+    auto usage = processor.getEngine().getSampleMemoryUsage();
+
+    auto text = "MEM: " + juce::File::descriptionOfSizeInBytes ((juce::int64) usage.heapBytes);
+    if (usage.mappedBytes > 0)
+        text << " + " << juce::File::descriptionOfSizeInBytes ((juce::int64) usage.mappedBytes) << " MAPPED";
+
+    if (text != memoryText)
+    {
+        memoryText = text;
+        repaint (getLocalBounds().removeFromBottom (32));
+    }
 }
 
 void PulsePluginEditor::resized()
 {
     auto area = getLocalBounds();
-    header.setBounds (area.removeFromTop (44));
-    area.removeFromBottom (32); // footer
+    auto headerArea = area.removeFromTop (44);
+    header.setBounds (headerArea);
+
+    // Centred between the title and the header's info text
+    auto kitArea = headerArea.withSizeKeepingCentre (260, 24);
+    saveKitButton.setBounds (kitArea.removeFromRight (48));
+    kitArea.removeFromRight (4);
+    kitBox.setBounds (kitArea);
+    auto footer = area.removeFromBottom (32).reduced (20, 7);
+    footer.removeFromRight (56); // version label
+    interpolationBox.setBounds (footer.removeFromRight (80));
+    footer.removeFromRight (52); // "INTERP" label
+    storageBox.setBounds (footer.removeFromRight (80));
+    footer.removeFromRight (56); // "STORAGE" label
+    embedButton.setBounds (footer.removeFromRight (48));
 
     auto stripArea = area.reduced (4, 4);
     int stripWidth = stripArea.getWidth() / Constants::NUM_PARTS;
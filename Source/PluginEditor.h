@@ -4,7 +4,8 @@
 #include "GUI/HeaderComponent.h"
 #include "GUI/VoiceStripComponent.h"
 
-class PulsePluginEditor : public juce::AudioProcessorEditor
+class PulsePluginEditor : public juce::AudioProcessorEditor,
+                          private juce::Timer
 {
 public:
     explicit PulsePluginEditor (PulsePluginProcessor& p);
@@ -14,9 +15,25 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+    void refreshKitList();
+    void saveKit();
+
     PulsePluginProcessor& processor;
     HeaderComponent header;
     juce::OwnedArray<VoiceStripComponent> voiceStrips;
 
+    // Kit library, in the header
+    juce::ComboBox kitBox;
+    juce::TextButton saveKitButton { "SAVE" };
+    juce::StringArray kitNames;
+
+    // Footer settings
+    juce::ComboBox interpolationBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> interpolationAttachment;
+    juce::ComboBox storageBox;
+    juce::TextButton embedButton { "EMBED" };
+    juce::String memoryText;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PulsePluginEditor)
 };
@@ -1,16 +1,31 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include <set>
 
 PulsePluginProcessor::PulsePluginProcessor()
     : AudioProcessor (BusesProperties()
                           .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-      apvts (*this, nullptr, "PARAMETERS", createParameterLayout())
+      apvts (*this, nullptr, "PARAMETERS", createParameterLayout()),
+      sampleEmbedding (formatManager),
+      presetLibrary (engine, *this, formatManager)
 {
     formatManager.registerBasicFormats();
     engine.initParameters (apvts);
+    presetLibrary.onKitChanged = [this] { sampleLoadBroadcaster.sendChangeMessage(); };
+
+    slotParameters = PluginState::getSlotParameters (*this);
+    parameterTable = PluginState::makeParameterTable (slotParameters);
 }
 
-PulsePluginProcessor::~PulsePluginProcessor() {}
+PulsePluginProcessor::~PulsePluginProcessor()
+{
+    // Loads in flight refer to formatManager and the broadcaster
+    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+    {
+        engine.getVoice (i).getSample1().cancelPendingLoads();
+        engine.getVoice (i).getSample2().cancelPendingLoads();
+    }
+}
 
 void PulsePluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
@@ -31,6 +46,7 @@ void PulsePluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
 {
     juce::ScopedNoDenormals noDenormals;
     buffer.clear();
+    engine.setNonRealtime (isNonRealtime());
     engine.processBlock (buffer, midiMessages);
 }
 
@@ -41,46 +57,198 @@ juce::AudioProcessorEditor* PulsePluginProcessor::createEditor()
 
 void PulsePluginProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
+    PluginState state;
+    state.parameterTable = parameterTable;
+    state.parameterValues.reserve (slotParameters.size());
+
+    for (auto* param : slotParameters)
+        state.parameterValues.push_back (param->convertFrom0to1 (param->getValue()));
+
+    state.sampleStorage = (int) sampleStorage;
+    state.embedSamples = embedSamples;
 
-    // Save sample file paths
+    std::set<juce::uint64> embeddedHashes;
+
+    // Save the samples' original paths, plus the audio itself when embedding
+    // is on. The embed list has one hash per path line (empty where the file
+    // is only referenced by path, or its blob is still being prepared).
     for (int i = 0; i < Constants::NUM_PARTS; ++i)
     {
         auto& voice = engine.getVoice (i);
-        state.setProperty ("p" + juce::String (i + 1) + "_s1_path",
-                           voice.getSample1().getFilePath(), nullptr);
-        state.setProperty ("p" + juce::String (i + 1) + "_s2_path",
-                           voice.getSample2().getFilePath(), nullptr);
+        auto& part = state.parts[(size_t) i];
+
+        part.synthTable = voice.getSynth().getUserTableFile().getFullPathName();
+
+        for (auto [player, slot] : { std::pair (&voice.getSample1(), (size_t) 0),
+                                     std::pair (&voice.getSample2(), (size_t) 1) })
+        {
+            auto path = player->getSourcePath();
+            part.samplePaths[slot] = path;
+
+            if (! embedSamples || path.isEmpty())
+                continue;
+
+            // The blobs come from the files actually loaded, which may be
+            // embedded copies of originals that are gone
+            auto loaded = juce::StringArray::fromLines (player->getFilePath());
+
+            juce::StringArray hashes;
+            for (int line = 0; line < loaded.size(); ++line)
+            {
+                auto blob = juce::File::isAbsolutePath (loaded[line])
+                                ? sampleEmbedding.getPreparedBlob (juce::File (loaded[line])) : nullptr;
+                hashes.add (blob != nullptr ? SampleEmbedding::hashToString (blob->hash) : juce::String());
+
+                if (blob != nullptr && embeddedHashes.insert (blob->hash).second)
+                    state.embedded.push_back (blob);
+            }
+
+            part.sampleEmbeds[slot] = hashes.joinIntoString ("\n");
+        }
     }
 
-    if (auto xml = state.createXml())
-        copyXmlToBinary (*xml, destData);
+    state.writeBinary (destData);
 }
 
 void PulsePluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    if (auto xml = getXmlFromBinary (data, sizeInBytes))
+    // The whole state is replaced, so a kit switch in progress is moot
+    presetLibrary.cancelSwitch();
+
+    PluginState state;
+
+    if (PluginState::isBinary (data, sizeInBytes))
+    {
+        if (! state.readBinary (data, sizeInBytes))
+            return;
+
+        restoreParameters (state);
+    }
+    else if (auto xml = getXmlFromBinary (data, sizeInBytes))
     {
-        auto state = juce::ValueTree::fromXml (*xml);
-        if (state.isValid())
+        // Sessions saved before the binary format
+        auto tree = juce::ValueTree::fromXml (*xml);
+        if (! tree.isValid())
+            return;
+
+        state.readLegacyTree (tree);
+
+        // Keep the audio out of the parameter tree
+        tree.removeChild (tree.getChildWithName ("EMBEDDED"), nullptr);
+        apvts.replaceState (tree);
+    }
+    else
+    {
+        return;
+    }
+
+    restoreSamples (state);
+}
+
+void PulsePluginProcessor::restoreParameters (const PluginState& state)
+{
+    // Parameters the state doesn't know keep their values
+    std::vector<float> current;
+    current.reserve (slotParameters.size());
+    for (auto* param : slotParameters)
+        current.push_back (param->convertFrom0to1 (param->getValue()));
+
+    auto values = state.getValuesForSlots (parameterTable, std::move (current));
+
+    for (size_t i = 0; i < slotParameters.size(); ++i)
+        slotParameters[i]->setValueNotifyingHost (slotParameters[i]->convertTo0to1 (values[i]));
+}
+
+void PulsePluginProcessor::restoreSamples (PluginState& state)
+{
+    sampleStorage = (SamplePlayer::Storage) juce::jlimit (0, 2, state.sampleStorage);
+    embedSamples = state.embedSamples;
+    presetLibrary.setSampleStorage (sampleStorage);
+
+    // Embedded copies stand in for originals that are missing or changed
+    state.extractEmbeddedSamples();
+
+    // All slots decode in parallel on the worker pool; each keeps playing
+    // its previous sample until it's ready
+    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+    {
+        auto& voice = engine.getVoice (i);
+        auto& part = state.parts[(size_t) i];
+
+        // Single-cycle tables are small enough to read right here
+        if (part.synthTable.isNotEmpty())
+            voice.getSynth().loadUserTable (juce::File (part.synthTable), formatManager);
+
+        for (auto [player, slot] : { std::pair (&voice.getSample1(), (size_t) 0),
+                                     std::pair (&voice.getSample2(), (size_t) 1) })
         {
-            apvts.replaceState (state);
+            player->storage = sampleStorage;
+            loadSlotAsync (*player, part.loadPaths[slot], part.samplePaths[slot]);
+        }
+    }
+}
 
-            // Restore sample paths
-            for (int i = 0; i < Constants::NUM_PARTS; ++i)
-            {
-                auto& voice = engine.getVoice (i);
-                auto s1Path = state.getProperty ("p" + juce::String (i + 1) + "_s1_path").toString();
-                auto s2Path = state.getProperty ("p" + juce::String (i + 1) + "_s2_path").toString();
+void PulsePluginProcessor::setSampleStorage (SamplePlayer::Storage newStorage)
+{
+    if (newStorage == sampleStorage)
+        return;
 
-                voice.getSample1().loadFromPath (s1Path, formatManager);
-                voice.getSample2().loadFromPath (s2Path, formatManager);
-            }
+    sampleStorage = newStorage;
+    presetLibrary.setSampleStorage (newStorage);
+    reloadSamples();
+}
+
+void PulsePluginProcessor::reloadSamples()
+{
+    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+    {
+        auto& voice = engine.getVoice (i);
+        for (auto* player : { &voice.getSample1(), &voice.getSample2() })
+        {
+            player->storage = sampleStorage;
+            loadSlotAsync (*player, player->getFilePath(), player->getSourcePath());
         }
     }
 }
 
+void PulsePluginProcessor::setEmbedSamples (bool shouldEmbed)
+{
+    embedSamples = shouldEmbed;
+    prepareEmbeddedSamples();
+}
+
+void PulsePluginProcessor::prepareEmbeddedSamples()
+{
+    if (! embedSamples)
+        return;
+
+    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+    {
+        auto& voice = engine.getVoice (i);
+        for (auto* player : { &voice.getSample1(), &voice.getSample2() })
+            for (auto& line : juce::StringArray::fromLines (player->getFilePath()))
+                if (juce::File::isAbsolutePath (line))
+                    sampleEmbedding.prepare (juce::File (line));
+    }
+}
+
+void PulsePluginProcessor::loadSlotAsync (SamplePlayer& player, const juce::String& path, const juce::String& sourcePath)
+{
+    player.loadFromPathAsync (path, formatManager, [this]
+    {
+        prepareEmbeddedSamples();
+        sampleLoadBroadcaster.sendChangeMessage();
+    }, sourcePath);
+}
+
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new PulsePluginProcessor();
 }
+
+int PulsePluginProcessor::saveKit (const juce::File& file)
+{
+    juce::MemoryBlock state;
+    getStateInformation (state);
+    return presetLibrary.savePreset (file, state);
+}
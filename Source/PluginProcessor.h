@@ -4,6 +4,9 @@
 #include <juce_audio_utils/juce_audio_utils.h>
 #include "DSP/DrumEngine.h"
 #include "Utility/Parameters.h"
+#include "Utility/SampleEmbedding.h"
+#include "Utility/PluginState.h"
+#include "Utility/PresetLibrary.h"
 
 class PulsePluginProcessor : public juce::AudioProcessor
 {
@@ -27,10 +30,11 @@ public:
     bool isMidiEffect() const override { return false; }
     double getTailLengthSeconds() const override { return 0.0; }
 
-    int getNumPrograms() override { return 1; }
-    int getCurrentProgram() override { return 0; }
-    void setCurrentProgram (int) override {}
-    const juce::String getProgramName (int) override { return {}; }
+    // Programs are the kits in the preset library
+    int getNumPrograms() override { return juce::jmax (1, presetLibrary.getNumPresets()); }
+    int getCurrentProgram() override { return juce::jmax (0, presetLibrary.getCurrentIndex()); }
+    void setCurrentProgram (int index) override { presetLibrary.selectFromAnyThread (index); }
+    const juce::String getProgramName (int index) override { return presetLibrary.getPresetName (index); }
     void changeProgramName (int, const juce::String&) override {}
 
     void getStateInformation (juce::MemoryBlock& destData) override;
@@ -39,10 +43,46 @@ public:
     juce::AudioProcessorValueTreeState apvts;
     DrumEngine& getEngine() { return engine; }
     juce::AudioFormatManager& getFormatManager() { return formatManager; }
+    PresetLibrary& getPresetLibrary() { return presetLibrary; }
+
+    // Saves the current state as a kit; returns its library index or -1
+    int saveKit (const juce::File& file);
+
+    // How this instance holds its samples in memory. Changing it reloads
+    // every loaded sample; saved with the plugin state (message thread).
+    void setSampleStorage (SamplePlayer::Storage newStorage);
+    SamplePlayer::Storage getSampleStorage() const { return sampleStorage; }
+
+    // When on, saved state carries the sample audio as well as its paths.
+    // The audio is packed in the background as samples load, so a save made
+    // before it's ready refers to those samples by path.
+    void setEmbedSamples (bool shouldEmbed);
+    bool getEmbedSamples() const { return embedSamples; }
+
+    // Queues packing of every loaded sample when embedding is on; call after
+    // loading samples outside the processor (any thread)
+    void prepareEmbeddedSamples();
+
+    // Notifies listeners on the message thread whenever an async sample load
+    // (state restore, storage change) has been published
+    juce::ChangeBroadcaster sampleLoadBroadcaster;
 
 private:
+    void reloadSamples();
+    void restoreParameters (const PluginState& state);
+    void restoreSamples (PluginState& state);
+    void loadSlotAsync (SamplePlayer& player, const juce::String& path, const juce::String& sourcePath);
+
     DrumEngine engine;
     juce::AudioFormatManager formatManager;
+    SamplePlayer::Storage sampleStorage = SamplePlayer::Storage::MemoryMapped;
+    SampleEmbedding sampleEmbedding;
+    std::atomic<bool> embedSamples { false };
+    PresetLibrary presetLibrary;
+
+    // The binary state's parameter slots: every parameter in layout order
+    std::vector<juce::RangedAudioParameter*> slotParameters;
+    juce::String parameterTable;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PulsePluginProcessor)
 };
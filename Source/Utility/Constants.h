@@ -9,6 +9,10 @@ namespace Constants
     constexpr float MAX_SAMPLE_LENGTH_SECS = 30.0f;
     constexpr int DEFAULT_BASE_NOTE = 60;
 
+    // Embedded samples larger than this (source file or encoded) are saved
+    // by path only
+    constexpr juce::int64 MAX_EMBEDDED_SAMPLE_BYTES = 16 * 1024 * 1024;
+
     // GM drum map notes for channel 10 mode
     constexpr int GM_KICK  = 36;
     constexpr int GM_SNARE = 38;
@@ -30,6 +30,13 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
         partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
             pid (ParamIDs::S1_START), pname ("S1 Start"),
             juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 0.0f));
+        partGroup->addChild (std::make_unique<juce::AudioParameterBool>(
+            pid (ParamIDs::S1_TRIM), pname ("S1 Auto Trim"), false));
+        partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
+            pid (ParamIDs::S1_TRANS), pname ("S1 Transient"),
+            juce::StringArray { "Off", "1", "2", "3", "4", "5", "6", "7", "8" }, 0));
+        partGroup->addChild (std::make_unique<juce::AudioParameterBool>(
+            pid (ParamIDs::S1_NORM), pname ("S1 Auto Gain"), false));
 
         // --- Sample 2 ---
         partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
@@ -41,11 +48,21 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
         partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
             pid (ParamIDs::S2_START), pname ("S2 Start"),
             juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 0.0f));
+        partGroup->addChild (std::make_unique<juce::AudioParameterBool>(
+            pid (ParamIDs::S2_TRIM), pname ("S2 Auto Trim"), false));
+        partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
+            pid (ParamIDs::S2_TRANS), pname ("S2 Transient"),
+            juce::StringArray { "Off", "1", "2", "3", "4", "5", "6", "7", "8" }, 0));
+        partGroup->addChild (std::make_unique<juce::AudioParameterBool>(
+            pid (ParamIDs::S2_NORM), pname ("S2 Auto Gain"), false));
 
         // --- Synth Osc ---
         partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
             pid (ParamIDs::SYN_WAVE), pname ("Synth Wave"),
-            juce::StringArray { "Sine", "Triangle", "Saw", "Square" }, 0));
+            juce::StringArray { "Sine", "Triangle", "Saw", "Square", "User" }, 0));
+        partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
+            pid (ParamIDs::SYN_MODE), pname ("Synth Mode"),
+            juce::StringArray { "Analog", "Wavetable", "FM" }, 0));
         partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
             pid (ParamIDs::SYN_LEVEL), pname ("Synth Level"),
             juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), i == 0 ? 0.6f : 0.3f));
@@ -58,11 +75,22 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
         partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
             pid (ParamIDs::SYN_FREQ), pname ("Synth Freq"),
             juce::NormalisableRange<float> (20.0f, 2000.0f, 0.1f, 0.3f), i == 0 ? 60.0f : 200.0f));
+        partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
+            pid (ParamIDs::SYN_RATIO), pname ("Synth FM Ratio"),
+            juce::NormalisableRange<float> (0.25f, 16.0f, 0.01f, 0.4f), 2.0f));
+        partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
+            pid (ParamIDs::SYN_INDEX), pname ("Synth FM Index"),
+            juce::NormalisableRange<float> (0.0f, 16.0f, 0.01f, 0.5f), 2.0f));
+        partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
+            pid (ParamIDs::SYN_FMENV), pname ("Synth FM Env"),
+            juce::StringArray { "Off", "Env 1", "Env 2", "Env 3", "Env 4" }, 0));
 
         // --- Noise ---
+        // New types go at the end so saved indices keep their meaning
+        // (normalised host automation still shifts with each addition)
         partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
             pid (ParamIDs::NSE_TYPE), pname ("Noise Type"),
-            juce::StringArray { "White", "Pink", "Metallic" }, 0));
+            juce::StringArray { "White", "Pink", "Metallic", "808 Metal" }, 0));
         partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
             pid (ParamIDs::NSE_LEVEL), pname ("Noise Level"),
             juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), i == 2 ? 0.7f : 0.15f));
@@ -72,6 +100,20 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
         partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
             pid (ParamIDs::NSE_TONE), pname ("Noise Tone"),
             juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 0.5f));
+        partGroup->addChild (std::make_unique<juce::AudioParameterInt>(
+            pid (ParamIDs::NSE_SEED), pname ("Noise Seed"), 0, 999, 0));
+        partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
+            pid (ParamIDs::NSE_FMODE), pname ("Noise Filter Mode"),
+            juce::StringArray { "1-Pole", "Lowpass", "Bandpass", "Highpass" }, 0));
+        partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
+            pid (ParamIDs::NSE_RES), pname ("Noise Resonance"),
+            juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 0.0f));
+        partGroup->addChild (std::make_unique<juce::AudioParameterChoice>(
+            pid (ParamIDs::NSE_FENV), pname ("Noise Filter Env"),
+            juce::StringArray { "Off", "Env 1", "Env 2", "Env 3", "Env 4" }, 0));
+        partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
+            pid (ParamIDs::NSE_FAMT), pname ("Noise Filter Env Amount"),
+            juce::NormalisableRange<float> (-8.0f, 8.0f, 0.01f), 0.0f));
 
         // --- 4 Envelopes ---
         for (int e = 0; e < Constants::NUM_ENVELOPES_PER_PART; ++e)
@@ -92,6 +134,17 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
             partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
                 eid (e, ParamIDs::ENV_R), pname ("Env" + juce::String (e + 1) + " R"),
                 juce::NormalisableRange<float> (0.01f, 2.0f, 0.001f, 0.3f), defR));
+
+            // Segment curves, -1 to +1; 0 is linear
+            partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
+                eid (e, ParamIDs::ENV_AC), pname ("Env" + juce::String (e + 1) + " A Curve"),
+                juce::NormalisableRange<float> (-1.0f, 1.0f, 0.01f), 0.0f));
+            partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
+                eid (e, ParamIDs::ENV_DC), pname ("Env" + juce::String (e + 1) + " D Curve"),
+                juce::NormalisableRange<float> (-1.0f, 1.0f, 0.01f), 0.0f));
+            partGroup->addChild (std::make_unique<juce::AudioParameterFloat>(
+                eid (e, ParamIDs::ENV_RC), pname ("Env" + juce::String (e + 1) + " R Curve"),
+                juce::NormalisableRange<float> (-1.0f, 1.0f, 0.01f), 0.0f));
         }
 
         // --- Envelope Assignments (which env index 0-3 controls each source) ---
@@ -131,5 +184,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
         layout.add (std::move (partGroup));
     }
 
+    // --- Global ---
+    layout.add (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID { ParamIDs::INTERP, 1 }, "Sample Interpolation",
+        juce::StringArray { "Linear", "Hermite", "Sinc" }, 0));
+
     return layout;
 }
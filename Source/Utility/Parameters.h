@@ -17,24 +17,42 @@ namespace ParamIDs
     const juce::String S1_LEVEL  = "s1_lvl";
     const juce::String S1_TUNE   = "s1_tune";
     const juce::String S1_START  = "s1_start";
+    const juce::String S1_TRIM   = "s1_trim";
+    const juce::String S1_TRANS  = "s1_trans";
+    const juce::String S1_NORM   = "s1_norm";
     const juce::String S2_LEVEL  = "s2_lvl";
     const juce::String S2_TUNE   = "s2_tune";
     const juce::String S2_START  = "s2_start";
+    const juce::String S2_TRIM   = "s2_trim";
+    const juce::String S2_TRANS  = "s2_trans";
+    const juce::String S2_NORM   = "s2_norm";
     const juce::String SYN_WAVE  = "syn_wave";
+    const juce::String SYN_MODE  = "syn_mode";
     const juce::String SYN_LEVEL = "syn_lvl";
     const juce::String SYN_TUNE  = "syn_tune";
     const juce::String SYN_PW    = "syn_pw";
     const juce::String SYN_FREQ  = "syn_freq";
+    const juce::String SYN_RATIO = "syn_ratio";
+    const juce::String SYN_INDEX = "syn_index";
+    const juce::String SYN_FMENV = "syn_fmenv";
     const juce::String NSE_TYPE  = "nse_type";
     const juce::String NSE_LEVEL = "nse_lvl";
     const juce::String NSE_FILT  = "nse_filt";
     const juce::String NSE_TONE  = "nse_tone";
+    const juce::String NSE_SEED  = "nse_seed";
+    const juce::String NSE_FMODE = "nse_fmode";
+    const juce::String NSE_RES   = "nse_res";
+    const juce::String NSE_FENV  = "nse_fenv";
+    const juce::String NSE_FAMT  = "nse_famt";
 
     // Envelope ADSR suffixes (used with envParam)
     const juce::String ENV_A = "a";
     const juce::String ENV_D = "d";
     const juce::String ENV_S = "s";
     const juce::String ENV_R = "r";
+    const juce::String ENV_AC = "ac";
+    const juce::String ENV_DC = "dc";
+    const juce::String ENV_RC = "rc";
 
     // Envelope assignment
     const juce::String EA_S1  = "ea_s1";
@@ -51,6 +69,9 @@ namespace ParamIDs
     const juce::String PAN  = "pan";
     const juce::String MUTE = "mute";
     const juce::String SOLO = "solo";
+
+    // Global (not part-prefixed)
+    const juce::String INTERP = "interp";
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
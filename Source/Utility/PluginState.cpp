@@ -0,0 +1,281 @@
+#include "PluginState.h"
+#include "../DSP/SampleAnalysisCache.h"
+#include <map>
+
+namespace
+{
+    // "PLSB", little-endian
+    constexpr int magic = 0x42534c50;
+
+    void writeBlob (juce::OutputStream& out, const void* data, size_t size)
+    {
+        out.writeCompressedInt ((int) size);
+        out.write (data, size);
+    }
+
+    void writeString (juce::OutputStream& out, const juce::String& s)
+    {
+        writeBlob (out, s.toRawUTF8(), s.getNumBytesAsUTF8());
+    }
+
+    // Length-checked against what's left, so a corrupt length can't
+    // allocate or read past the end
+    bool readBlob (juce::MemoryInputStream& in, juce::MemoryBlock& dest)
+    {
+        auto size = in.readCompressedInt();
+        if (size < 0 || size > in.getNumBytesRemaining())
+            return false;
+
+        dest.setSize ((size_t) size);
+        return in.read (dest.getData(), size) == size;
+    }
+
+    bool readString (juce::MemoryInputStream& in, juce::String& dest)
+    {
+        auto size = in.readCompressedInt();
+        if (size < 0 || size > in.getNumBytesRemaining())
+            return false;
+
+        dest = juce::String::fromUTF8 (static_cast<const char*> (in.getData()) + in.getPosition(), size);
+        return in.setPosition (in.getPosition() + size);
+    }
+}
+
+void PluginState::writeBinary (juce::MemoryBlock& dest) const
+{
+    juce::MemoryOutputStream out (dest, false);
+
+    out.writeInt (magic);
+    out.writeInt (formatVersion);
+
+    auto ids = juce::StringArray::fromLines (parameterTable);
+    jassert (ids.size() == (int) parameterValues.size());
+
+    out.writeInt64 ((juce::int64) hashLayout (parameterTable));
+    out.writeCompressedInt ((int) parameterValues.size());
+    for (size_t i = 0; i < parameterValues.size(); ++i)
+    {
+        out.writeInt64 ((juce::int64) hashParameterID (ids[(int) i]));
+        out.writeFloat (parameterValues[i]);
+    }
+
+    out.writeCompressedInt (sampleStorage);
+    out.writeByte (embedSamples ? 1 : 0);
+
+    for (auto& part : parts)
+    {
+        writeString (out, part.synthTable);
+        for (size_t slot = 0; slot < 2; ++slot)
+        {
+            writeString (out, part.samplePaths[slot]);
+            writeString (out, part.sampleEmbeds[slot]);
+        }
+    }
+
+    out.writeCompressedInt ((int) embedded.size());
+    for (auto& blob : embedded)
+    {
+        out.writeInt64 ((juce::int64) blob->hash);
+        writeString (out, blob->fileName);
+        writeBlob (out, blob->data.getData(), blob->data.getSize());
+    }
+}
+
+bool PluginState::isBinary (const void* data, int sizeInBytes)
+{
+    return sizeInBytes >= 8 && juce::ByteOrder::littleEndianInt (data) == (juce::uint32) magic;
+}
+
+bool PluginState::readBinary (const void* data, int sizeInBytes)
+{
+    if (! isBinary (data, sizeInBytes))
+        return false;
+
+    juce::MemoryInputStream in (data, (size_t) sizeInBytes, false);
+    in.readInt();
+
+    // Earlier versions never left development builds
+    if (in.readInt() != formatVersion)
+        return false;
+
+    layoutHash = (juce::uint64) in.readInt64();
+
+    auto numSlots = in.readCompressedInt();
+    if (numSlots < 0 || (juce::int64) numSlots * 12 > in.getNumBytesRemaining())
+        return false;
+
+    slotIDs.resize ((size_t) numSlots);
+    parameterValues.resize ((size_t) numSlots);
+    for (size_t i = 0; i < (size_t) numSlots; ++i)
+    {
+        slotIDs[i] = (juce::uint64) in.readInt64();
+        parameterValues[i] = in.readFloat();
+    }
+
+    sampleStorage = in.readCompressedInt();
+    embedSamples = in.readByte() != 0;
+
+    for (auto& part : parts)
+    {
+        if (! readString (in, part.synthTable))
+            return false;
+
+        for (size_t slot = 0; slot < 2; ++slot)
+            if (! readString (in, part.samplePaths[slot]) || ! readString (in, part.sampleEmbeds[slot]))
+                return false;
+    }
+
+    auto numEmbedded = in.readCompressedInt();
+    if (numEmbedded < 0)
+        return false;
+
+    embedded.clear();
+    for (int i = 0; i < numEmbedded; ++i)
+    {
+        auto blob = std::make_shared<SampleEmbedding::Blob>();
+        blob->hash = (juce::uint64) in.readInt64();
+
+        if (! readString (in, blob->fileName) || ! readBlob (in, blob->data))
+            return false;
+
+        embedded.push_back (std::move (blob));
+    }
+
+    return true;
+}
+
+void PluginState::readLegacyTree (const juce::ValueTree& tree)
+{
+    sampleStorage = tree.getProperty ("sample_storage", 0);
+    embedSamples = tree.getProperty ("embed_samples", false);
+
+    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+    {
+        auto& part = parts[(size_t) i];
+        auto prefix = "p" + juce::String (i + 1);
+
+        part.synthTable = tree.getProperty (prefix + "_syn_table").toString();
+        part.samplePaths[0] = tree.getProperty (prefix + "_s1_path").toString();
+        part.samplePaths[1] = tree.getProperty (prefix + "_s2_path").toString();
+        part.sampleEmbeds[0] = tree.getProperty (prefix + "_s1_embed").toString();
+        part.sampleEmbeds[1] = tree.getProperty (prefix + "_s2_embed").toString();
+    }
+
+    embedded.clear();
+    auto samples = tree.getChildWithName ("EMBEDDED");
+
+    for (int i = 0; i < samples.getNumChildren(); ++i)
+    {
+        auto sample = samples.getChild (i);
+
+        if (auto* data = sample.getProperty ("data").getBinaryData())
+        {
+            auto blob = std::make_shared<SampleEmbedding::Blob>();
+            blob->hash = (juce::uint64) sample.getProperty ("hash").toString().getHexValue64();
+            blob->fileName = sample.getProperty ("name").toString();
+            blob->data = *data;
+            embedded.push_back (std::move (blob));
+        }
+    }
+}
+
+std::vector<float> PluginState::getValuesForSlots (const juce::String& table, std::vector<float> fallback) const
+{
+    // Saved with the same layout: nothing to rearrange
+    if (layoutHash == hashLayout (table) && parameterValues.size() == fallback.size())
+        return parameterValues;
+
+    // Otherwise match the slots by the hashes of their IDs
+    auto targetIDs = juce::StringArray::fromLines (table);
+    std::map<juce::uint64, float> saved;
+
+    for (size_t i = 0; i < slotIDs.size() && i < parameterValues.size(); ++i)
+        saved[slotIDs[i]] = parameterValues[i];
+
+    for (int i = 0; i < targetIDs.size() && i < (int) fallback.size(); ++i)
+    {
+        auto it = saved.find (hashParameterID (targetIDs[i]));
+        if (it != saved.end())
+            fallback[(size_t) i] = it->second;
+    }
+
+    return fallback;
+}
+
+void PluginState::extractEmbeddedSamples()
+{
+    std::map<juce::String, std::shared_ptr<const SampleEmbedding::Blob>> blobs;
+    for (auto& blob : embedded)
+        blobs[SampleEmbedding::hashToString (blob->hash)] = blob;
+
+    std::map<juce::String, juce::File> extracted;
+    auto getCopy = [&] (const juce::String& hash)
+    {
+        auto it = extracted.find (hash);
+        if (it != extracted.end())
+            return it->second;
+
+        auto blob = blobs.find (hash);
+        auto file = blob == blobs.end() ? juce::File()
+                                        : SampleEmbedding::extract (hash, blob->second->fileName, blob->second->data);
+        extracted[hash] = file;
+        return file;
+    };
+
+    for (auto& part : parts)
+    {
+        for (size_t slot = 0; slot < 2; ++slot)
+        {
+            auto paths = juce::StringArray::fromLines (part.samplePaths[slot]);
+            auto hashes = juce::StringArray::fromLines (part.sampleEmbeds[slot]);
+
+            for (int line = 0; line < paths.size() && line < hashes.size(); ++line)
+            {
+                if (hashes[line].isEmpty() || blobs.count (hashes[line]) == 0)
+                    continue;
+
+                // The original wins unless it's gone or its content changed
+                if (juce::File::isAbsolutePath (paths[line])
+                    && juce::File (paths[line]).existsAsFile()
+                    && SampleEmbedding::hashToString (SampleAnalysisCache::hashFile (juce::File (paths[line]))) == hashes[line])
+                    continue;
+
+                auto copy = getCopy (hashes[line]);
+                if (copy.existsAsFile())
+                    paths.set (line, copy.getFullPathName());
+            }
+
+            part.loadPaths[slot] = paths.joinIntoString ("\n");
+        }
+    }
+}
+
+std::vector<juce::RangedAudioParameter*> PluginState::getSlotParameters (juce::AudioProcessor& processor)
+{
+    std::vector<juce::RangedAudioParameter*> slots;
+
+    for (auto* param : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (param))
+            slots.push_back (ranged);
+
+    return slots;
+}
+
+juce::String PluginState::makeParameterTable (const std::vector<juce::RangedAudioParameter*>& slots)
+{
+    juce::StringArray ids;
+    for (auto* param : slots)
+        ids.add (param->getParameterID());
+
+    return ids.joinIntoString ("\n");
+}
+
+juce::uint64 PluginState::hashLayout (const juce::String& table)
+{
+    return (juce::uint64) table.hashCode64();
+}
+
+juce::uint64 PluginState::hashParameterID (const juce::String& parameterID)
+{
+    return (juce::uint64) parameterID.hashCode64();
+}
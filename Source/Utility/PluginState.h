@@ -0,0 +1,69 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "Constants.h"
+#include "SampleEmbedding.h"
+
+// Everything the processor saves besides the parameter tree's own layout,
+// in a form both state formats decode into.
+//
+// The binary format is a magic number and version, then every parameter as
+// a float in a fixed slot, then the rest as length-prefixed fields. Each
+// slot carries a hash of its parameter ID, and the whole layout a hash of
+// its ID table: a reader whose layout matches assigns slots by index, any
+// other matches them by ID hash. Older sessions were saved as an XML
+// ValueTree, which is still read (readLegacyTree).
+struct PluginState
+{
+    static constexpr int formatVersion = 3;
+
+    struct Part
+    {
+        juce::String synthTable;
+        std::array<juce::String, 2> samplePaths;    // one path per line
+        std::array<juce::String, 2> sampleEmbeds;   // one hash per path line
+
+        // Not saved: the files to load, line-for-line with samplePaths (set
+        // by extractEmbeddedSamples)
+        std::array<juce::String, 2> loadPaths;
+    };
+
+    // Slot IDs, one per line, for writing; saved only as hashes
+    juce::String parameterTable;
+    juce::uint64 layoutHash = 0;          // of the saved table, once read
+    std::vector<juce::uint64> slotIDs;    // saved ID hashes, once read
+    std::vector<float> parameterValues;   // denormalised, one per slot
+
+    int sampleStorage = 0;
+    bool embedSamples = false;
+    std::array<Part, Constants::NUM_PARTS> parts;
+    std::vector<std::shared_ptr<const SampleEmbedding::Blob>> embedded;
+
+    void writeBinary (juce::MemoryBlock& dest) const;
+
+    // True if data starts with the binary format's magic number
+    static bool isBinary (const void* data, int sizeInBytes);
+
+    // Fails on truncated data or another format version
+    bool readBinary (const void* data, int sizeInBytes);
+
+    // Reads the non-parameter fields of an XML-era state tree; the
+    // parameters themselves are restored with replaceState
+    void readLegacyTree (const juce::ValueTree& tree);
+
+    // This state's parameter values rearranged into another slot order;
+    // slots the state doesn't have keep their value from fallback
+    std::vector<float> getValuesForSlots (const juce::String& table, std::vector<float> fallback) const;
+
+    // Chooses the file to load for every sample path line: the original
+    // while it exists with the embedded content, otherwise the embedded copy,
+    // unpacked into the local extraction folder (a hash unpacked before is
+    // just looked up). samplePaths keep the originals so the next save
+    // refers to them again.
+    void extractEmbeddedSamples();
+
+    // Every parameter of a processor, in slot order, and their ID table
+    static std::vector<juce::RangedAudioParameter*> getSlotParameters (juce::AudioProcessor& processor);
+    static juce::String makeParameterTable (const std::vector<juce::RangedAudioParameter*>& slots);
+    static juce::uint64 hashLayout (const juce::String& table);
+    static juce::uint64 hashParameterID (const juce::String& parameterID);
+};
@@ -0,0 +1,342 @@
+#include "PresetLibrary.h"
+#include "PluginState.h"
+
+namespace
+{
+    // If no block has run by then the audio isn't running, and the kit is
+    // handed over without waiting for it
+    constexpr juce::uint32 switchTimeoutMs = 500;
+}
+
+class PresetLibrary::PreloadJob : public juce::ThreadPoolJob
+{
+public:
+    PreloadJob (PresetLibrary& l, int indexToLoad, juce::File fileToLoad, SamplePlayer::Storage sampleStorage)
+        : juce::ThreadPoolJob ("PULSE kit preload"),
+          owner (l), index (indexToLoad), file (std::move (fileToLoad)), storage (sampleStorage)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto kit = owner.decode (file, storage);
+
+        if (! shouldExit())
+        {
+            const juce::ScopedLock sl (owner.preloadLock);
+
+            // A later preload owns the slot now
+            if (owner.preloadingIndex == index)
+            {
+                owner.preloadingIndex = -1;
+
+                // A kit that can't be read is recorded, so a switch waiting
+                // for it gives up instead of waiting forever
+                if (kit == nullptr)
+                {
+                    owner.unreadable.insert (index);
+                }
+                else
+                {
+                    owner.preloaded = std::move (kit);
+                    owner.preloadedIndex = index;
+                    owner.unreadable.erase (index);
+                }
+            }
+        }
+
+        return jobHasFinished;
+    }
+
+    PresetLibrary& owner;
+
+private:
+    int index;
+    juce::File file;
+    SamplePlayer::Storage storage;
+};
+
+PresetLibrary::PresetLibrary (DrumEngine& e, juce::AudioProcessor& processor, juce::AudioFormatManager& fm)
+    : engine (e), formatManager (fm), folder (getDefaultFolder())
+{
+    slotParameters = PluginState::getSlotParameters (processor);
+    parameterTable = PluginState::makeParameterTable (slotParameters);
+
+    for (auto* param : slotParameters)
+        defaults.push_back (param->convertFrom0to1 (param->getDefaultValue()));
+
+    rescan();
+}
+
+PresetLibrary::~PresetLibrary()
+{
+    cancelPendingUpdate();
+
+    struct OwnJobs : public juce::ThreadPool::JobSelector
+    {
+        explicit OwnJobs (PresetLibrary& l) : library (l) {}
+
+        bool isJobSuitable (juce::ThreadPoolJob* job) override
+        {
+            auto* preload = dynamic_cast<PreloadJob*> (job);
+            return preload != nullptr && &preload->owner == &library;
+        }
+
+        PresetLibrary& library;
+    };
+
+    // No timeout: a running job refers to this library
+    OwnJobs selector (*this);
+    workerPool->removeAllJobs (true, -1, &selector);
+}
+
+juce::File PresetLibrary::getDefaultFolder()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("PULSE")
+               .getChildFile ("Kits");
+}
+
+void PresetLibrary::rescan()
+{
+    auto current = getPresetFile (currentIndex);
+
+    files.clear();
+    for (auto& file : folder.findChildFiles (juce::File::findFiles, false, juce::String ("*") + fileExtension))
+        files.add (file);
+
+    std::sort (files.begin(), files.end(), [] (const juce::File& a, const juce::File& b)
+               {
+                   return a.getFileName().compareNatural (b.getFileName()) < 0;
+               });
+
+    // Indices may have moved; the current kit keeps its place, the
+    // preloaded one is dropped
+    currentIndex = -1;
+    for (int i = 0; i < files.size(); ++i)
+        if (files[i] == current)
+            currentIndex = i;
+
+    const juce::ScopedLock sl (preloadLock);
+    preloadingIndex = -1;
+    preloadedIndex = -1;
+    preloaded = nullptr;
+    unreadable.clear();
+    requestedIndex = -1;
+}
+
+juce::String PresetLibrary::getPresetName (int index) const
+{
+    return getPresetFile (index).getFileNameWithoutExtension();
+}
+
+juce::File PresetLibrary::getPresetFile (int index) const
+{
+    return juce::isPositiveAndBelow (index, files.size()) ? files[index] : juce::File();
+}
+
+bool PresetLibrary::isUnreadable (int index) const
+{
+    const juce::ScopedLock sl (preloadLock);
+    return unreadable.count (index) > 0;
+}
+
+void PresetLibrary::preload (int index)
+{
+    if (! juce::isPositiveAndBelow (index, files.size()))
+        return;
+
+    {
+        const juce::ScopedLock sl (preloadLock);
+        if (index == preloadedIndex || index == preloadingIndex || unreadable.count (index) > 0)
+            return;
+
+        preloadingIndex = index;
+    }
+
+    workerPool->addJob (new PreloadJob (*this, index, files[index], storage), true);
+}
+
+void PresetLibrary::select (int index)
+{
+    if (! juce::isPositiveAndBelow (index, files.size()))
+        return;
+
+    std::shared_ptr<const Kit> ready;
+    {
+        const juce::ScopedLock sl (preloadLock);
+        if (index == preloadedIndex)
+            ready = preloaded;
+
+        // Selecting a kit that failed before tries it again
+        unreadable.erase (index);
+    }
+
+    if (ready != nullptr)
+    {
+        requestedIndex = -1;
+        publish (std::move (ready), index);
+        return;
+    }
+
+    requestedIndex = index;
+    preload (index);
+    startTimer (20);
+}
+
+void PresetLibrary::selectFromAnyThread (int index)
+{
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        select (index);
+        return;
+    }
+
+    pendingSelect.store (index);
+    triggerAsyncUpdate();
+}
+
+void PresetLibrary::handleAsyncUpdate()
+{
+    auto index = pendingSelect.exchange (-1);
+    if (index >= 0)
+        select (index);
+}
+
+void PresetLibrary::cancelSwitch()
+{
+    pendingSelect.store (-1);
+    requestedIndex = -1;
+
+    if (switching != nullptr)
+    {
+        switching = nullptr;
+        engine.publishKit (nullptr);
+    }
+}
+
+int PresetLibrary::savePreset (const juce::File& file, const juce::MemoryBlock& state)
+{
+    auto target = file.withFileExtension (fileExtension);
+
+    if (! target.getParentDirectory().createDirectory()
+        || ! target.replaceWithData (state.getData(), state.getSize()))
+        return -1;
+
+    if (target.getParentDirectory() != folder)
+        return -1;
+
+    rescan();
+
+    for (int i = 0; i < files.size(); ++i)
+        if (files[i] == target)
+            return currentIndex = i;
+
+    return -1;
+}
+
+void PresetLibrary::publish (std::shared_ptr<const Kit> kit, int index)
+{
+    // Finish a switch still waiting for the audio thread first
+    if (switching != nullptr)
+        handOver();
+
+    switching = kit;
+    switchStartedMs = juce::Time::getMillisecondCounter();
+    currentIndex = index;
+    engine.publishKit (std::move (kit));
+    startTimer (20);
+
+    // Ready the next kit in the set
+    preload ((index + 1) % files.size());
+}
+
+void PresetLibrary::timerCallback()
+{
+    // A selected kit that was still decoding
+    if (requestedIndex >= 0)
+    {
+        std::shared_ptr<const Kit> ready;
+        bool failed;
+        {
+            const juce::ScopedLock sl (preloadLock);
+            if (requestedIndex == preloadedIndex)
+                ready = preloaded;
+
+            failed = unreadable.count (requestedIndex) > 0;
+        }
+
+        if (ready != nullptr)
+        {
+            auto index = std::exchange (requestedIndex, -1);
+            publish (std::move (ready), index);
+        }
+        else if (failed)
+        {
+            // The current kit stays; isUnreadable reports why
+            requestedIndex = -1;
+        }
+    }
+
+    if (switching != nullptr
+        && (engine.getAppliedKitGeneration() == switching->generation
+            || juce::Time::getMillisecondCounter() - switchStartedMs > switchTimeoutMs))
+        handOver();
+
+    if (requestedIndex < 0 && switching == nullptr)
+        stopTimer();
+}
+
+void PresetLibrary::handOver()
+{
+    // The audio thread already plays all of this; it becomes the
+    // processor's own state so the host, GUI and saves see it
+    auto kit = std::exchange (switching, nullptr);
+
+    for (size_t i = 0; i < slotParameters.size() && i < kit->parameterValues.size(); ++i)
+        slotParameters[i]->setValueNotifyingHost (slotParameters[i]->convertTo0to1 (kit->parameterValues[i]));
+
+    for (int i = 0; i < Constants::NUM_PARTS; ++i)
+    {
+        auto& voice = engine.getVoice (i);
+        auto& part = kit->parts[(size_t) i];
+
+        voice.getSample1().setZones (part.zones[0]);
+        voice.getSample2().setZones (part.zones[1]);
+        voice.getSynth().setUserTable (part.userTable);
+    }
+
+    engine.publishKit (nullptr);
+
+    if (onKitChanged != nullptr)
+        onKitChanged();
+}
+
+std::shared_ptr<const Kit> PresetLibrary::decode (const juce::File& file, SamplePlayer::Storage sampleStorage) const
+{
+    juce::MemoryBlock data;
+    PluginState state;
+
+    if (! file.loadFileAsData (data) || ! state.readBinary (data.getData(), (int) data.getSize()))
+        return nullptr;
+
+    state.extractEmbeddedSamples();
+
+    auto kit = std::make_shared<Kit>();
+    kit->generation = ++lastKitGeneration;
+    kit->parameterValues = state.getValuesForSlots (parameterTable, defaults);
+
+    for (size_t i = 0; i < kit->parts.size(); ++i)
+    {
+        auto& part = state.parts[i];
+
+        for (size_t slot = 0; slot < 2; ++slot)
+            kit->parts[i].zones[slot] = SamplePlayer::createZonesFromPath (part.loadPaths[slot], formatManager, sampleStorage,
+                                                                            part.samplePaths[slot]);
+
+        if (part.synthTable.isNotEmpty())
+            kit->parts[i].userTable = Wavetable::fromFile (juce::File (part.synthTable), formatManager);
+    }
+
+    return kit;
+}
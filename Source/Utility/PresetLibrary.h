@@ -0,0 +1,100 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "../DSP/DrumEngine.h"
+#include "WorkerPool.h"
+#include <set>
+
+// An indexed folder of kits, each saved in the plugin's binary state
+// format. A kit is decoded on the worker pool ahead of time (parameters,
+// samples and user tables), so selecting it is one publish to the engine,
+// which switches every part at its next block. Once the audio thread has
+// switched, the kit is handed over to the parameters and slots on the
+// message thread, where it can take its time.
+//
+// All calls are on the message thread, except selectFromAnyThread and
+// getCurrentIndex.
+class PresetLibrary : private juce::Timer,
+                      private juce::AsyncUpdater
+{
+public:
+    static constexpr const char* fileExtension = ".pulsekit";
+
+    PresetLibrary (DrumEngine& engine, juce::AudioProcessor& processor, juce::AudioFormatManager& formatManager);
+    ~PresetLibrary() override;
+
+    static juce::File getDefaultFolder();
+    const juce::File& getFolder() const { return folder; }
+    void rescan();
+
+    int getNumPresets() const { return files.size(); }
+    juce::String getPresetName (int index) const;
+    juce::File getPresetFile (int index) const;
+    int getCurrentIndex() const { return currentIndex; }
+
+    // True if the kit's file couldn't be read or decoded the last time it
+    // was tried. Selecting it again retries; a rescan forgets the failures.
+    bool isUnreadable (int index) const;
+
+    // Decodes a kit in the background so selecting it is instant. One kit
+    // is held ready at a time.
+    void preload (int index);
+
+    // Switches to a kit: at once if it's preloaded, else as soon as it is.
+    // If it fails to decode, the current kit stays. The kit after it in the
+    // list is preloaded next.
+    void select (int index);
+
+    // As select, for hosts that change programs from other threads (some do
+    // from the audio thread): the request is passed to the message thread
+    void selectFromAnyThread (int index);
+
+    // Drops a switch in progress, e.g. when the whole state is replaced
+    void cancelSwitch();
+
+    // Writes a kit file and rescans; returns its index, or -1 if it failed
+    // or isn't in the library folder
+    int savePreset (const juce::File& file, const juce::MemoryBlock& state);
+
+    // Storage used for the samples of kits decoded from now on
+    void setSampleStorage (SamplePlayer::Storage newStorage) { storage = newStorage; }
+
+    // Called after a kit has been handed over, e.g. to refresh sample names
+    std::function<void()> onKitChanged;
+
+private:
+    class PreloadJob;
+
+    void timerCallback() override;
+    void handleAsyncUpdate() override;
+    void publish (std::shared_ptr<const Kit> kit, int index);
+    void handOver();
+    std::shared_ptr<const Kit> decode (const juce::File& file, SamplePlayer::Storage sampleStorage) const;
+
+    DrumEngine& engine;
+    juce::AudioFormatManager& formatManager;
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+
+    std::vector<juce::RangedAudioParameter*> slotParameters;
+    juce::String parameterTable;
+    std::vector<float> defaults;   // denormalised, for slots a kit doesn't have
+    mutable std::atomic<juce::uint32> lastKitGeneration { 0 };   // decode runs on the worker pool
+
+    juce::File folder;
+    juce::Array<juce::File> files;
+    SamplePlayer::Storage storage = SamplePlayer::Storage::MemoryMapped;
+
+    // The ready kit; set by preload jobs
+    juce::CriticalSection preloadLock;
+    int preloadingIndex = -1;
+    int preloadedIndex = -1;
+    std::shared_ptr<const Kit> preloaded;
+    std::set<int> unreadable;
+
+    int requestedIndex = -1;   // selected, still decoding
+    std::atomic<int> currentIndex { -1 };
+    std::atomic<int> pendingSelect { -1 };   // from selectFromAnyThread
+    std::shared_ptr<const Kit> switching;   // published, not yet handed over
+    juce::uint32 switchStartedMs = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetLibrary)
+};
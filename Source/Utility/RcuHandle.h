@@ -0,0 +1,63 @@
+#pragma once
+#include <juce_core/juce_core.h>
+#include "ReleasePool.h"
+#include <utility>
+
+// Publishes immutable objects to a single realtime reader. The reader takes a
+// plain pointer between beginRead() and endRead(), with no locks and no
+// reference counting. A replaced object is handed to the release pool, which
+// frees it once the reader has left the read section that might still see it.
+//
+// Writers may publish from any non-realtime thread.
+template <typename T>
+class RcuHandle
+{
+public:
+    RcuHandle() : readerEpoch (std::make_shared<std::atomic<juce::uint32>> (0)) {}
+
+    void publish (std::shared_ptr<const T> object)
+    {
+        const juce::ScopedLock sl (writerLock);
+
+        live.store (object.get());
+
+        // An odd epoch means the reader is inside a read section that may
+        // have loaded the old pointer; it's done once the epoch moves on
+        auto epoch = readerEpoch->load();
+        auto retired = std::exchange (owner, std::move (object));
+
+        if (retired != nullptr)
+            releasePool->add (retired, [counter = readerEpoch, epoch]
+                              {
+                                  return (epoch & 1) == 0 || counter->load() != epoch;
+                              });
+    }
+
+    // Owning reference for non-realtime readers
+    std::shared_ptr<const T> get() const
+    {
+        const juce::ScopedLock sl (writerLock);
+        return owner;
+    }
+
+    // Realtime reader: the pointer stays valid until endRead()
+    const T* beginRead() noexcept
+    {
+        readerEpoch->fetch_add (1);
+        return live.load();
+    }
+
+    void endRead() noexcept
+    {
+        readerEpoch->fetch_add (1);
+    }
+
+private:
+    juce::SharedResourcePointer<ReleasePool> releasePool;
+    mutable juce::CriticalSection writerLock;
+    std::shared_ptr<const T> owner;
+    std::atomic<const T*> live { nullptr };
+    std::shared_ptr<std::atomic<juce::uint32>> readerEpoch;
+
+    JUCE_DECLARE_NON_COPYABLE (RcuHandle)
+};
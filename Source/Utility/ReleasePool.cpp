@@ -0,0 +1,44 @@
+#include "ReleasePool.h"
+#include <algorithm>
+#include <iterator>
+
+ReleasePool::ReleasePool()
+    : juce::Thread ("PULSE release pool")
+{
+    startThread (juce::Thread::Priority::background);
+}
+
+ReleasePool::~ReleasePool()
+{
+    stopThread (1000);
+}
+
+void ReleasePool::run()
+{
+    while (! threadShouldExit())
+    {
+        wait (collectionIntervalMs);
+        collect();
+    }
+}
+
+void ReleasePool::collect()
+{
+    std::vector<Entry> released;
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        // Nothing else can gain a reference to an object the pool holds
+        // alone, so moving it out and freeing it unlocked is safe
+        auto unused = std::stable_partition (pool.begin(), pool.end(), [] (const Entry& entry)
+        {
+            return entry.object.use_count() > 1 || (entry.isReleasable != nullptr && ! entry.isReleasable());
+        });
+
+        std::move (unused, pool.end(), std::back_inserter (released));
+        pool.erase (unused, pool.end());
+    }
+
+    // released goes out of scope here, freeing the objects on this thread
+}
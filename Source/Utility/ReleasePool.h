@@ -0,0 +1,43 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+// Keeps a reference to objects shared with the audio thread so that the last
+// reference is never dropped there. A background thread frees each object
+// once the pool holds the only reference (and its isReleasable check, if
+// any, passes), within one collection interval. Share a single pool per
+// process through juce::SharedResourcePointer.
+class ReleasePool : private juce::Thread
+{
+public:
+    static constexpr int collectionIntervalMs = 100;
+
+    ReleasePool();
+    ~ReleasePool() override;
+
+    // Call before the audio thread can see the object, or once it's retired.
+    // isReleasable runs on the pool thread.
+    template <typename T>
+    void add (const std::shared_ptr<T>& object, std::function<bool()> isReleasable = nullptr)
+    {
+        if (object == nullptr)
+            return;
+
+        const juce::ScopedLock sl (lock);
+        pool.push_back ({ object, std::move (isReleasable) });
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const void> object;
+        std::function<bool()> isReleasable;
+    };
+
+    void run() override;
+    void collect();
+
+    juce::CriticalSection lock;
+    std::vector<Entry> pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReleasePool)
+};
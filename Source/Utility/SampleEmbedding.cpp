@@ -0,0 +1,170 @@
+#include "SampleEmbedding.h"
+#include "Constants.h"
+#include "../DSP/SampleAnalysisCache.h"
+
+class SampleEmbedding::BlobJob : public juce::ThreadPoolJob
+{
+public:
+    BlobJob (SampleEmbedding& e, juce::File fileToEmbed)
+        : juce::ThreadPoolJob ("PULSE sample embed"), owner (e), file (std::move (fileToEmbed))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        owner.build (file);
+        return jobHasFinished;
+    }
+
+    SampleEmbedding& owner;
+
+private:
+    juce::File file;
+};
+
+SampleEmbedding::SampleEmbedding (juce::AudioFormatManager& fm)
+    : formatManager (fm)
+{
+}
+
+SampleEmbedding::~SampleEmbedding()
+{
+    struct OwnJobs : public juce::ThreadPool::JobSelector
+    {
+        explicit OwnJobs (SampleEmbedding& e) : embedding (e) {}
+
+        bool isJobSuitable (juce::ThreadPoolJob* job) override
+        {
+            auto* blobJob = dynamic_cast<BlobJob*> (job);
+            return blobJob != nullptr && &blobJob->owner == &embedding;
+        }
+
+        SampleEmbedding& embedding;
+    };
+
+    // No timeout: a running job refers to this object
+    OwnJobs selector (*this);
+    workerPool->removeAllJobs (true, -1, &selector);
+}
+
+void SampleEmbedding::prepare (const juce::File& file)
+{
+    std::shared_ptr<const Blob> blob;
+    if (findCached (file, blob))
+        return;
+
+    {
+        const juce::ScopedLock sl (lock);
+        if (! building.insert (file.getFullPathName()).second)
+            return;
+    }
+
+    workerPool->addJob (new BlobJob (*this, file), true);
+}
+
+std::shared_ptr<const SampleEmbedding::Blob> SampleEmbedding::getPreparedBlob (const juce::File& file)
+{
+    std::shared_ptr<const Blob> blob;
+    if (! findCached (file, blob))
+        prepare (file);
+
+    return blob;
+}
+
+bool SampleEmbedding::findCached (const juce::File& file, std::shared_ptr<const Blob>& blob)
+{
+    auto size = file.getSize();
+    auto modified = file.getLastModificationTime().toMilliseconds();
+
+    const juce::ScopedLock sl (lock);
+    auto it = cache.find (file.getFullPathName());
+    if (it == cache.end() || it->second.size != size || it->second.modified != modified)
+        return false;
+
+    blob = it->second.blob;
+    return true;
+}
+
+void SampleEmbedding::build (const juce::File& file)
+{
+    auto size = file.getSize();
+    auto modified = file.getLastModificationTime().toMilliseconds();
+    auto blob = createBlob (file);
+
+    const juce::ScopedLock sl (lock);
+    cache[file.getFullPathName()] = { size, modified, blob };
+    building.erase (file.getFullPathName());
+}
+
+std::shared_ptr<const SampleEmbedding::Blob> SampleEmbedding::createBlob (const juce::File& file)
+{
+    if (! file.existsAsFile() || file.getSize() > Constants::MAX_EMBEDDED_SAMPLE_BYTES * 4)
+        return nullptr;
+
+    auto blob = std::make_shared<Blob>();
+    blob->hash = SampleAnalysisCache::hashFile (file);
+    if (blob->hash == 0)
+        return nullptr;
+
+    auto ext = file.getFileExtension().toLowerCase();
+    bool isPcm = ext == ".wav" || ext == ".aif" || ext == ".aiff";
+
+    if (isPcm)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+        if (reader != nullptr && ! reader->usesFloatingPointData && reader->bitsPerSample <= 24
+            && reader->numChannels <= 8)
+        {
+            juce::FlacAudioFormat flac;
+            auto* stream = new juce::MemoryOutputStream (blob->data, false);
+            std::unique_ptr<juce::AudioFormatWriter> writer (flac.createWriterFor (stream, reader->sampleRate, reader->numChannels,
+                                                                                   reader->bitsPerSample <= 16 ? 16 : 24, {}, 5));
+            if (writer == nullptr)
+            {
+                delete stream;
+                return nullptr;
+            }
+
+            if (! writer->writeFromAudioReader (*reader, 0, reader->lengthInSamples))
+                return nullptr;
+
+            writer.reset();  // flushes into blob->data
+            blob->fileName = file.getFileNameWithoutExtension() + ".flac";
+        }
+    }
+
+    // Already compressed, or not something FLAC can hold: keep the file as is
+    if (blob->fileName.isEmpty())
+    {
+        if (! file.loadFileAsData (blob->data))
+            return nullptr;
+        blob->fileName = file.getFileName();
+    }
+
+    if ((juce::int64) blob->data.getSize() > Constants::MAX_EMBEDDED_SAMPLE_BYTES)
+        return nullptr;
+
+    return blob;
+}
+
+juce::File SampleEmbedding::extract (const juce::String& hash, const juce::String& fileName, const juce::MemoryBlock& data)
+{
+    if (hash.isEmpty() || fileName.isEmpty() || data.isEmpty()
+        || ! hash.containsOnly ("0123456789abcdef") || fileName.containsAnyOf ("/\\:"))
+        return {};
+
+    auto file = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                    .getChildFile ("PULSE")
+                    .getChildFile ("Embedded")
+                    .getChildFile (hash)
+                    .getChildFile (fileName);
+
+    if (file.existsAsFile() && file.getSize() == (juce::int64) data.getSize())
+        return file;
+
+    if (! file.getParentDirectory().createDirectory() || ! file.replaceWithData (data.getData(), data.getSize()))
+        return {};
+
+    return file;
+}
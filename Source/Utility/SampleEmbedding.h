@@ -0,0 +1,62 @@
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <map>
+#include <set>
+#include "WorkerPool.h"
+
+// Packs sample files into the plugin state and unpacks them again.
+// Uncompressed 16/24-bit WAV/AIFF is FLAC-encoded; files that are already
+// compressed, or that FLAC can't hold, are stored as they are. Blobs are
+// identified by a content hash so a file used by several slots is stored
+// once. Blobs are built on the worker pool ahead of a save (prepare) and
+// cached, so saving never encodes or hashes audio itself.
+class SampleEmbedding
+{
+public:
+    struct Blob
+    {
+        juce::uint64 hash = 0;
+        juce::String fileName;   // original name with the blob's extension
+        juce::MemoryBlock data;
+    };
+
+    explicit SampleEmbedding (juce::AudioFormatManager& formatManager);
+    ~SampleEmbedding();
+
+    // Builds the file's blob on the worker pool, unless an up-to-date one is
+    // cached or already being built (any thread)
+    void prepare (const juce::File& file);
+
+    // The file's cached blob if it's up to date. nullptr if the file can't be
+    // embedded (unreadable, or over MAX_EMBEDDED_SAMPLE_BYTES) or its blob
+    // isn't ready yet, in which case a build is queued.
+    std::shared_ptr<const Blob> getPreparedBlob (const juce::File& file);
+
+    // Writes the blob into the local extraction folder (once per hash) and
+    // returns the file to load, or an invalid File on failure
+    static juce::File extract (const juce::String& hash, const juce::String& fileName, const juce::MemoryBlock& data);
+
+    static juce::String hashToString (juce::uint64 hash) { return juce::String::toHexString ((juce::int64) hash); }
+
+private:
+    class BlobJob;
+
+    bool findCached (const juce::File& file, std::shared_ptr<const Blob>& blob);
+    void build (const juce::File& file);
+    std::shared_ptr<const Blob> createBlob (const juce::File& file);
+
+    juce::AudioFormatManager& formatManager;
+
+    struct CacheEntry
+    {
+        juce::int64 size, modified;
+        std::shared_ptr<const Blob> blob;
+    };
+
+    juce::CriticalSection lock;
+    std::map<juce::String, CacheEntry> cache;   // keyed by full path
+    std::set<juce::String> building;
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+
+    JUCE_DECLARE_NON_COPYABLE (SampleEmbedding)
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <juce_core/juce_core.h>
+
+// Process-wide pool for background sample work such as analysis. Share it
+// through juce::SharedResourcePointer so every plugin instance uses the same
+// threads.
+class WorkerPool : public juce::ThreadPool
+{
+public:
+    WorkerPool()
+        : juce::ThreadPool (juce::ThreadPoolOptions()
+                                .withThreadName ("PULSE worker")
+                                .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumCpus() - 1))
+                                .withDesiredThreadPriority (juce::Thread::Priority::low))
+    {
+    }
+};